@@ -9,18 +9,24 @@
 #include "GameFramework/Character.h"
 #include "DrawDebugHelpers.h"
 #include "Components/ShooterHealthComponent.h"
+#include "Components/ShooterHitboxHistoryComponent.h"
 #include "ShooterCharacter.h"
 #include "Components/SphereComponent.h"
 #include "Sound/SoundCue.h"
 #include "EngineUtils.h"
 
 
+#if UE_SERVER
+/* Nothing is drawn on a dedicated server, the debug branches compile away */
+static const int32 DebugTrackerBotDrawing = 0;
+#else
 static int32 DebugTrackerBotDrawing = 0;
 FAutoConsoleVariableRef CVARDebugTrackerBotDrawing(
 	TEXT("COOP.DebugTrackerBot"),
 	DebugTrackerBotDrawing,
 	TEXT("Draw Debug Lines for TrackerBot"),
 	ECVF_Cheat);
+#endif
 
 
 // Sets default values
@@ -35,7 +41,7 @@ AShooterTrackerBot::AShooterTrackerBot()
 	RootComponent = MeshComp;
 
 	HealthComp = CreateDefaultSubobject<UShooterHealthComponent>(TEXT("HealthComp"));
-	HealthComp->OnHealthChanged.AddDynamic(this, &AShooterTrackerBot::HandleTakeDamage);
+	HealthComp->OnHealthChangedNative.AddUObject(this, &AShooterTrackerBot::HandleTakeDamage);
 
 	SphereComp = CreateDefaultSubobject<USphereComponent>(TEXT("SphereComp"));
 	SphereComp->SetSphereRadius(200);
@@ -44,6 +50,10 @@ AShooterTrackerBot::AShooterTrackerBot()
 	SphereComp->SetCollisionResponseToChannel(ECC_Pawn, ECR_Overlap);
 	SphereComp->SetupAttachment(RootComponent);
 
+	/* Single sphere around the ball, sized from the mesh bounds on begin play */
+	HitboxHistoryComp = CreateDefaultSubobject<UShooterHitboxHistoryComponent>(TEXT("HitboxHistoryComp"));
+	HitboxHistoryComp->SetHitboxes({ FShooterHitbox(NAME_None, NAME_None, 0.0f, SurfaceType_Default) });
+
 	bUseVelocityChange = false;
 	MovementForce = 1000;
 	RequiredDistanceToTarget = 100;
@@ -52,6 +62,8 @@ AShooterTrackerBot::AShooterTrackerBot()
 	ExplosionRadius = 350;
 
 	SelfDamageInterval = 0.25f;
+
+	ThinkIntervalScale = 1.0f;
 }
 
 // Called when the game starts or when spawned
@@ -62,15 +74,54 @@ void AShooterTrackerBot::BeginPlay()
 	if (HasAuthority())
 	{
 		NextPathPoint = GetNextPathPoint();
+	}
+
+	/* Sets the tick interval and starts the power level timer at the first tier's rate */
+	UShooterSignificanceSubsystem* Significance = GetWorld()->GetSubsystem<UShooterSignificanceSubsystem>();
+	if (Significance)
+	{
+		Significance->RegisterActor(this, FShooterSignificanceChanged::CreateUObject(this, &AShooterTrackerBot::OnSignificanceChanged));
+	}
+	else
+	{
+		OnSignificanceChanged(EShooterSignificance::High);
+	}
+}
+
+void AShooterTrackerBot::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	UShooterSignificanceSubsystem* Significance = GetWorld()->GetSubsystem<UShooterSignificanceSubsystem>();
+	if (Significance)
+	{
+		Significance->UnregisterActor(this);
+	}
+
+	Super::EndPlay(EndPlayReason);
+}
 
+void AShooterTrackerBot::OnSignificanceChanged(EShooterSignificance NewSignificance)
+{
+	SetActorTickInterval(UShooterSignificanceSubsystem::GetTickInterval(NewSignificance));
+
+	const float NewThinkIntervalScale = UShooterSignificanceSubsystem::GetThinkIntervalScale(NewSignificance);
+	if (HasAuthority() && (NewThinkIntervalScale != ThinkIntervalScale || !TimerHandle_CheckPowerLevel.IsValid()))
+	{
 		// Every second we update our power-level based on nearby bots (CHALLENGE CODE)
-		FTimerHandle TimerHandle_CheckPowerLevel;
-		GetWorldTimerManager().SetTimer(TimerHandle_CheckPowerLevel, this, &AShooterTrackerBot::OnCheckNearbyBots, 1.0f, true);
+		GetWorldTimerManager().SetTimer(TimerHandle_CheckPowerLevel, this, &AShooterTrackerBot::OnCheckNearbyBots, 1.0f * NewThinkIntervalScale, true);
 	}
+
+	ThinkIntervalScale = NewThinkIntervalScale;
 }
 
-void AShooterTrackerBot::HandleTakeDamage(UShooterHealthComponent* OwningHealthComp, float Health, float HealthDelta, const class UDamageType* DamageType, class AController* InstigatedBy, AActor* DamageCauser)
+void AShooterTrackerBot::HandleTakeDamage(const FShooterHealthChange& Change)
 {
+	if (bExploded && Change.Health > 0.0f)
+	{
+		RestoreFromExplosion();
+		return;
+	}
+
+#if !UE_SERVER
 	if (MatInst == nullptr)
 	{
 		MatInst = MeshComp->CreateAndSetMaterialInstanceDynamicFromMaterial(0, MeshComp->GetMaterial(0));
@@ -80,9 +131,10 @@ void AShooterTrackerBot::HandleTakeDamage(UShooterHealthComponent* OwningHealthC
 	{
 		MatInst->SetScalarParameterValue("LastTimeDamageTaken", GetWorld()->TimeSeconds);
 	}
+#endif
 
 	//Explode on hitpoints == 0
-	if (Health <= 0.0f)
+	if (Change.Health <= 0.0f)
 	{
 		SelfDestruct();
 	}
@@ -119,7 +171,7 @@ FVector AShooterTrackerBot::GetNextPathPoint()
 		UNavigationPath* NavPath = UNavigationSystemV1::FindPathToActorSynchronously(this, GetActorLocation(), BestTarget);
 
 		GetWorldTimerManager().ClearTimer(TimerHandle_RefreshPath);
-		GetWorldTimerManager().SetTimer(TimerHandle_RefreshPath, this, &AShooterTrackerBot::RefreshPath, 5.0f, false);
+		GetWorldTimerManager().SetTimer(TimerHandle_RefreshPath, this, &AShooterTrackerBot::RefreshPath, 5.0f * ThinkIntervalScale, false);
 
 		if (NavPath && NavPath->PathPoints.Num() > 1)
 		{
@@ -141,9 +193,11 @@ void AShooterTrackerBot::SelfDestruct()
 
 	bExploded = true;
 
+#if !UE_SERVER
 	UGameplayStatics::SpawnEmitterAtLocation(GetWorld(), ExplosionEffect, GetActorLocation());
 
 	UGameplayStatics::PlaySoundAtLocation(this, ExplodeSound, GetActorLocation());
+#endif
 
 	MeshComp->SetVisibility(false, true);
 	MeshComp->SetCollisionEnabled(ECollisionEnabled::NoCollision);
@@ -164,10 +218,64 @@ void AShooterTrackerBot::SelfDestruct()
 			DrawDebugSphere(GetWorld(), GetActorLocation(), ExplosionRadius, 12, FColor::Red, false, 2.0f, 0, 1.0f);
 		}
 
-		SetLifeSpan(2.0f);
+		/* Long enough for the explosion to reach clients, then stored for the next wave */
+		UShooterPawnRecyclerSubsystem* Recycler = GetWorld()->GetSubsystem<UShooterPawnRecyclerSubsystem>();
+		if (Recycler == nullptr || !Recycler->RetirePawn(this, 2.0f))
+		{
+			SetLifeSpan(2.0f);
+		}
+	}
+}
+
+void AShooterTrackerBot::RestoreFromExplosion()
+{
+	bExploded = false;
+	bStartedSelfDestruction = false;
+	PowerLevel = 0;
+
+	MeshComp->SetVisibility(true, true);
+	MeshComp->SetCollisionEnabled(GetClass()->GetDefaultObject<AShooterTrackerBot>()->MeshComp->GetCollisionEnabled());
+
+	if (HasAuthority())
+	{
+		MeshComp->SetSimulatePhysics(true);
+
+		NextPathPoint = GetNextPathPoint();
+
+		GetWorldTimerManager().SetTimer(TimerHandle_CheckPowerLevel, this, &AShooterTrackerBot::OnCheckNearbyBots, 1.0f * ThinkIntervalScale, true);
 	}
 }
 
+void AShooterTrackerBot::StoreCorpse()
+{
+	GetWorldTimerManager().ClearTimer(TimerHandle_SelfDamage);
+	GetWorldTimerManager().ClearTimer(TimerHandle_RefreshPath);
+	GetWorldTimerManager().ClearTimer(TimerHandle_CheckPowerLevel);
+
+	MeshComp->SetSimulatePhysics(false);
+
+	SetActorHiddenInGame(true);
+	SetActorEnableCollision(false);
+	SetActorTickEnabled(false);
+
+	HitboxHistoryComp->SetComponentTickEnabled(false);
+	HitboxHistoryComp->ClearHistory();
+}
+
+void AShooterTrackerBot::ResetForReuse(const FTransform& SpawnTransform)
+{
+	SetActorLocationAndRotation(SpawnTransform.GetLocation(), SpawnTransform.GetRotation(), false, nullptr, ETeleportType::ResetPhysics);
+
+	SetActorHiddenInGame(false);
+	SetActorEnableCollision(true);
+	SetActorTickEnabled(true);
+
+	HitboxHistoryComp->SetComponentTickEnabled(true);
+
+	/* The rest comes back through HandleTakeDamage, the same way it does on clients */
+	HealthComp->ResetHealth();
+}
+
 void AShooterTrackerBot::DamageSelf()
 {
 	UGameplayStatics::ApplyDamage(this, 20, GetInstigatorController(), this, nullptr);
@@ -199,7 +307,8 @@ void AShooterTrackerBot::Tick(float DeltaTime)
 
 			ForceDirection *= MovementForce;
 
-			MeshComp->AddForce(ForceDirection, NAME_None, bUseVelocityChange);
+			/* Push for the whole time since the last tick, distant bots tick less often but keep their speed */
+			MeshComp->AddImpulse(ForceDirection * DeltaTime, NAME_None, bUseVelocityChange);
 			if (DebugTrackerBotDrawing)
 			{
 				DrawDebugDirectionalArrow(GetWorld(), GetActorLocation(), GetActorLocation() + ForceDirection, 32, FColor::Yellow, false, 0.0f, 0, 1.0f);
@@ -233,7 +342,9 @@ void AShooterTrackerBot::NotifyActorBeginOverlap(AActor* OtherActor)
 
 			bStartedSelfDestruction = true;
 
+#if !UE_SERVER
 			UGameplayStatics::SpawnSoundAttached(SelfDestructSound, RootComponent);
+#endif
 		}
 	}
 }
@@ -282,6 +393,7 @@ void AShooterTrackerBot::OnCheckNearbyBots()
 	// Clamp between min=0 and max=4
 	PowerLevel = FMath::Clamp(NrOfBots, 0, MaxPowerLevel);
 
+#if !UE_SERVER
 	// Update the material color
 	if (MatInst == nullptr)
 	{
@@ -298,6 +410,7 @@ void AShooterTrackerBot::OnCheckNearbyBots()
 
 		MatInst->SetScalarParameterValue("PowerLevelAlpha", Alpha);
 	}
+#endif
 
 	if (DebugTrackerBotDrawing)
 	{
@@ -0,0 +1,122 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Animation/ShooterAnimInstance.h"
+#include "GameFramework/CharacterMovementComponent.h"
+#include "Components/ShooterFootIKComponent.h"
+
+
+FShooterAnimInstanceProxy::FShooterAnimInstanceProxy()
+	: PlayerPose(EPlayerPose::NoWeaponPose)
+	, bIsSprinting(false)
+	, bIsTargeting(false)
+	, bIsInitiatedJump(false)
+	, bIsFalling(false)
+	, AimPitch(0.0f)
+	, AimYaw(0.0f)
+	, Speed(0.0f)
+	, Direction(0.0f)
+	, LeftFootOffset(0.0f)
+	, RightFootOffset(0.0f)
+	, LeftFootRotation(ForceInit)
+	, RightFootRotation(ForceInit)
+	, HipOffset(0.0f)
+	, BaseAimRotation(ForceInit)
+	, Velocity(ForceInit)
+{
+}
+
+
+FShooterAnimInstanceProxy::FShooterAnimInstanceProxy(UAnimInstance* Instance)
+	: FAnimInstanceProxy(Instance)
+	, PlayerPose(EPlayerPose::NoWeaponPose)
+	, bIsSprinting(false)
+	, bIsTargeting(false)
+	, bIsInitiatedJump(false)
+	, bIsFalling(false)
+	, AimPitch(0.0f)
+	, AimYaw(0.0f)
+	, Speed(0.0f)
+	, Direction(0.0f)
+	, LeftFootOffset(0.0f)
+	, RightFootOffset(0.0f)
+	, LeftFootRotation(ForceInit)
+	, RightFootRotation(ForceInit)
+	, HipOffset(0.0f)
+	, BaseAimRotation(ForceInit)
+	, Velocity(ForceInit)
+{
+}
+
+
+void FShooterAnimInstanceProxy::PreUpdate(UAnimInstance* InAnimInstance, float DeltaSeconds)
+{
+	FAnimInstanceProxy::PreUpdate(InAnimInstance, DeltaSeconds);
+
+	const AShooterCharacter* Character = Cast<AShooterCharacter>(InAnimInstance->TryGetPawnOwner());
+	if (Character == nullptr)
+	{
+		return;
+	}
+
+	PlayerPose = Character->PlayerPose;
+	bIsSprinting = Character->IsSprinting();
+	bIsTargeting = Character->IsTargeting();
+	bIsInitiatedJump = Character->IsInitiatedJump();
+
+	const UCharacterMovementComponent* MoveComp = Character->GetCharacterMovement();
+	bIsFalling = MoveComp && MoveComp->IsFalling();
+
+	BaseAimRotation = Character->GetBaseAimRotation();
+	Velocity = Character->GetVelocity();
+	ActorTransform = Character->GetActorTransform();
+
+	const UShooterFootIKComponent* FootIK = Character->GetFootIKComp();
+	if (FootIK)
+	{
+		LeftFootOffset = FootIK->GetLeftFootOffset();
+		RightFootOffset = FootIK->GetRightFootOffset();
+		LeftFootRotation = FootIK->GetLeftFootRotation();
+		RightFootRotation = FootIK->GetRightFootRotation();
+		HipOffset = FootIK->GetHipOffset();
+	}
+}
+
+
+void FShooterAnimInstanceProxy::Update(float DeltaSeconds)
+{
+	FAnimInstanceProxy::Update(DeltaSeconds);
+
+	/* Same math as AShooterCharacter::GetAimOffsets, done here so the game thread only copies */
+	const FVector AimDirLS = ActorTransform.InverseTransformVectorNoScale(BaseAimRotation.Vector());
+	const FRotator AimRotLS = AimDirLS.Rotation();
+	AimPitch = AimRotLS.Pitch;
+	AimYaw = AimRotLS.Yaw;
+
+	Speed = Velocity.Size2D();
+
+	Direction = 0.0f;
+	if (Speed > KINDA_SMALL_NUMBER)
+	{
+		const FVector MoveDirLS = ActorTransform.InverseTransformVectorNoScale(Velocity);
+		Direction = FMath::RadiansToDegrees(FMath::Atan2(MoveDirLS.Y, MoveDirLS.X));
+	}
+}
+
+
+UShooterAnimInstance::UShooterAnimInstance(const FObjectInitializer& ObjectInitializer)
+	: Super(ObjectInitializer)
+	, Proxy(this)
+{
+}
+
+
+FAnimInstanceProxy* UShooterAnimInstance::CreateAnimInstanceProxy()
+{
+	return &Proxy;
+}
+
+
+void UShooterAnimInstance::DestroyAnimInstanceProxy(FAnimInstanceProxy* InProxy)
+{
+}
@@ -0,0 +1,84 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Animation/ShooterMeleeNotifyState.h"
+#include "Components/SkeletalMeshComponent.h"
+#include "Components/ShooterMeleeComponent.h"
+#include "ShooterCharacter.h"
+#include "ShooterWeapon.h"
+
+
+UShooterMeleeNotifyState::UShooterMeleeNotifyState()
+{
+	bTraceWeaponMesh = false;
+	StartSocket = "hand_r";
+	EndSocket = NAME_None;
+	Radius = 12.0f;
+	Damage = 20.0f;
+}
+
+
+UShooterMeleeComponent* UShooterMeleeNotifyState::GetMeleeComponent(USkeletalMeshComponent* MeshComp)
+{
+	AShooterCharacter* Character = MeshComp ? Cast<AShooterCharacter>(MeshComp->GetOwner()) : nullptr;
+	return Character ? Character->GetMeleeComp() : nullptr;
+}
+
+
+void UShooterMeleeNotifyState::NotifyBegin(USkeletalMeshComponent* MeshComp, UAnimSequenceBase* Animation, float TotalDuration)
+{
+	Super::NotifyBegin(MeshComp, Animation, TotalDuration);
+
+	UShooterMeleeComponent* MeleeComp = GetMeleeComponent(MeshComp);
+	if (MeleeComp == nullptr)
+	{
+		return;
+	}
+
+	USkeletalMeshComponent* TraceMesh = MeshComp;
+	AActor* DamageCauser = MeshComp->GetOwner();
+
+	if (bTraceWeaponMesh)
+	{
+		AShooterWeapon* Weapon = CastChecked<AShooterCharacter>(MeshComp->GetOwner())->GetCurrentWeapon();
+		if (Weapon == nullptr)
+		{
+			return;
+		}
+
+		TraceMesh = Weapon->GetWeaponMesh();
+		DamageCauser = Weapon;
+	}
+
+	MeleeComp->BeginSwing(TraceMesh, StartSocket, EndSocket, Radius, Damage, DamageType, DamageCauser);
+}
+
+
+void UShooterMeleeNotifyState::NotifyTick(USkeletalMeshComponent* MeshComp, UAnimSequenceBase* Animation, float FrameDeltaTime)
+{
+	Super::NotifyTick(MeshComp, Animation, FrameDeltaTime);
+
+	UShooterMeleeComponent* MeleeComp = GetMeleeComponent(MeshComp);
+	if (MeleeComp)
+	{
+		MeleeComp->TickSwing();
+	}
+}
+
+
+void UShooterMeleeNotifyState::NotifyEnd(USkeletalMeshComponent* MeshComp, UAnimSequenceBase* Animation)
+{
+	UShooterMeleeComponent* MeleeComp = GetMeleeComponent(MeshComp);
+	if (MeleeComp)
+	{
+		MeleeComp->EndSwing();
+	}
+
+	Super::NotifyEnd(MeshComp, Animation);
+}
+
+
+FString UShooterMeleeNotifyState::GetNotifyName_Implementation() const
+{
+	return TEXT("Melee Hit Window");
+}
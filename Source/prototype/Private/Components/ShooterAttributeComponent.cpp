@@ -0,0 +1,184 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Components/ShooterAttributeComponent.h"
+#include "Net/UnrealNetwork.h"
+
+
+bool FShooterAttributeModifier::NetSerialize(FArchive& Ar, class UPackageMap* Map, bool& bOutSuccess)
+{
+	/* Attribute and op share a byte, the handle is small and packs well */
+	uint8 AttributeAndOp = static_cast<uint8>((static_cast<uint8>(Attribute) << 2) | (static_cast<uint8>(Op) & 0x3));
+	Ar << AttributeAndOp;
+	if (Ar.IsLoading())
+	{
+		Attribute = static_cast<EShooterAttribute>(FMath::Min<uint8>(AttributeAndOp >> 2, static_cast<uint8>(EShooterAttribute::MAX) - 1));
+		Op = static_cast<EShooterModifierOp>(FMath::Min<uint8>(AttributeAndOp & 0x3, static_cast<uint8>(EShooterModifierOp::Override)));
+	}
+
+	Ar << Magnitude;
+
+	uint32 PackedHandle = static_cast<uint32>(FMath::Max(Handle, 0));
+	Ar.SerializeIntPacked(PackedHandle);
+	Handle = static_cast<int32>(PackedHandle);
+
+	bOutSuccess = true;
+	return true;
+}
+
+
+void FShooterModifierList::PostReplicatedAdd(const TArrayView<int32>& AddedIndices, int32 FinalSize)
+{
+	if (OwnerComponent)
+	{
+		OwnerComponent->MarkDirty();
+	}
+}
+
+
+void FShooterModifierList::PostReplicatedChange(const TArrayView<int32>& ChangedIndices, int32 FinalSize)
+{
+	if (OwnerComponent)
+	{
+		OwnerComponent->MarkDirty();
+	}
+}
+
+
+void FShooterModifierList::PreReplicatedRemove(const TArrayView<int32>& RemovedIndices, int32 FinalSize)
+{
+	/* Entries are still in the array here, the next read happens after they are gone */
+	if (OwnerComponent)
+	{
+		OwnerComponent->MarkDirty();
+	}
+}
+
+
+UShooterAttributeComponent::UShooterAttributeComponent()
+{
+	NextHandle = 0;
+	bDirty = true;
+
+	for (float& Value : CachedValues)
+	{
+		Value = 1.0f;
+	}
+
+	ActiveModifiers.OwnerComponent = this;
+
+	SetIsReplicatedByDefault(true);
+}
+
+
+void UShooterAttributeComponent::BeginPlay()
+{
+	Super::BeginPlay();
+
+	ActiveModifiers.OwnerComponent = this;
+}
+
+
+int32 UShooterAttributeComponent::AddModifier(EShooterAttribute Attribute, EShooterModifierOp Op, float Magnitude)
+{
+	if (GetOwnerRole() != ROLE_Authority || Attribute == EShooterAttribute::MAX)
+	{
+		return INDEX_NONE;
+	}
+
+	FShooterAttributeModifier& Modifier = ActiveModifiers.Modifiers.AddDefaulted_GetRef();
+	Modifier.Attribute = Attribute;
+	Modifier.Op = Op;
+	Modifier.Magnitude = Magnitude;
+	Modifier.Handle = NextHandle++;
+
+	ActiveModifiers.MarkItemDirty(Modifier);
+	MarkDirty();
+
+	return Modifier.Handle;
+}
+
+
+void UShooterAttributeComponent::RemoveModifier(int32 Handle)
+{
+	if (GetOwnerRole() != ROLE_Authority)
+	{
+		return;
+	}
+
+	const int32 Index = ActiveModifiers.Modifiers.IndexOfByPredicate([Handle](const FShooterAttributeModifier& Modifier) { return Modifier.Handle == Handle; });
+	if (Index == INDEX_NONE)
+	{
+		return;
+	}
+
+	ActiveModifiers.Modifiers.RemoveAtSwap(Index);
+	ActiveModifiers.MarkArrayDirty();
+	MarkDirty();
+}
+
+
+void UShooterAttributeComponent::ClearModifiers()
+{
+	if (GetOwnerRole() != ROLE_Authority || ActiveModifiers.Modifiers.Num() == 0)
+	{
+		return;
+	}
+
+	ActiveModifiers.Modifiers.Reset();
+	ActiveModifiers.MarkArrayDirty();
+	MarkDirty();
+}
+
+
+void UShooterAttributeComponent::Aggregate() const
+{
+	float Adds[(int32)EShooterAttribute::MAX] = {};
+	float Multipliers[(int32)EShooterAttribute::MAX];
+	int32 OverrideHandles[(int32)EShooterAttribute::MAX];
+	float Overrides[(int32)EShooterAttribute::MAX];
+
+	for (int32 i = 0; i < (int32)EShooterAttribute::MAX; i++)
+	{
+		Multipliers[i] = 1.0f;
+		OverrideHandles[i] = INDEX_NONE;
+		Overrides[i] = 0.0f;
+	}
+
+	for (const FShooterAttributeModifier& Modifier : ActiveModifiers.Modifiers)
+	{
+		const int32 i = (int32)Modifier.Attribute;
+		switch (Modifier.Op)
+		{
+		case EShooterModifierOp::Add:
+			Adds[i] += Modifier.Magnitude;
+			break;
+		case EShooterModifierOp::Multiply:
+			Multipliers[i] *= Modifier.Magnitude;
+			break;
+		case EShooterModifierOp::Override:
+			if (Modifier.Handle > OverrideHandles[i])
+			{
+				OverrideHandles[i] = Modifier.Handle;
+				Overrides[i] = Modifier.Magnitude;
+			}
+			break;
+		}
+	}
+
+	for (int32 i = 0; i < (int32)EShooterAttribute::MAX; i++)
+	{
+		CachedValues[i] = OverrideHandles[i] != INDEX_NONE ? Overrides[i] : (1.0f + Adds[i]) * Multipliers[i];
+	}
+
+	bDirty = false;
+}
+
+
+void UShooterAttributeComponent::GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const
+{
+	Super::GetLifetimeReplicatedProps(OutLifetimeProps);
+
+	/* Only the owner predicts with the modifiers, everyone else sees the results */
+	DOREPLIFETIME_CONDITION(UShooterAttributeComponent, ActiveModifiers, COND_OwnerOnly);
+}
@@ -0,0 +1,206 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Components/ShooterFootIKComponent.h"
+#include "Components/SkeletalMeshComponent.h"
+#include "Components/CapsuleComponent.h"
+#include "GameFramework/Character.h"
+#include "GameFramework/CharacterMovementComponent.h"
+#include "Engine/World.h"
+#include "Animation/ShooterAnimInstance.h"
+#include "../prototype.h"
+
+DECLARE_DWORD_COUNTER_STAT(TEXT("FootIK Traces"), STAT_FootIKTraces, STATGROUP_Prototype);
+
+
+UShooterFootIKComponent::UShooterFootIKComponent()
+{
+	PrimaryComponentTick.bCanEverTick = true;
+
+	LeftFootSocket = "foot_l";
+	RightFootSocket = "foot_r";
+	TraceUpDistance = 50.0f;
+	TraceDownDistance = 50.0f;
+	InterpSpeed = 15.0f;
+	BlendSpeed = 4.0f;
+	StationarySpeed = 1.0f;
+
+	HipOffset = 0.0f;
+	Alpha = 1.0f;
+	bIKEnabled = true;
+	bHasIKReader = false;
+	bHasTraceResults = false;
+	LastTraceLocation = FVector::ZeroVector;
+
+	for (FFoot& Foot : Feet)
+	{
+		Foot.TargetOffset = 0.0f;
+		Foot.TargetRotation = FRotator::ZeroRotator;
+		Foot.Offset = 0.0f;
+		Foot.Rotation = FRotator::ZeroRotator;
+		Foot.bTracePending = false;
+	}
+}
+
+
+void UShooterFootIKComponent::BeginPlay()
+{
+	Super::BeginPlay();
+
+	Feet[0].Socket = LeftFootSocket;
+	Feet[1].Socket = RightFootSocket;
+
+	ACharacter* Character = Cast<ACharacter>(GetOwner());
+	SkeletalMesh = Character ? Character->GetMesh() : GetOwner()->FindComponentByClass<USkeletalMeshComponent>();
+
+	/* An anim Blueprint not parented to UShooterAnimInstance does its own foot traces, ours would only add to them */
+	bHasIKReader = SkeletalMesh && Cast<UShooterAnimInstance>(SkeletalMesh->GetAnimInstance());
+
+	/* Feet are cosmetic, a dedicated server never needs them */
+	if (!bHasIKReader || GetNetMode() == NM_DedicatedServer)
+	{
+		SetComponentTickEnabled(false);
+		return;
+	}
+
+	/* Sample the feet of this frame's pose, the next animation update picks up the offsets */
+	AddTickPrerequisiteComponent(SkeletalMesh);
+
+	TraceDelegate.BindUObject(this, &UShooterFootIKComponent::OnTraceCompleted);
+}
+
+
+void UShooterFootIKComponent::SetIKEnabled(bool bEnabled)
+{
+	if (bIKEnabled == bEnabled)
+	{
+		return;
+	}
+
+	bIKEnabled = bEnabled;
+
+	if (bIKEnabled && bHasIKReader && GetNetMode() != NM_DedicatedServer)
+	{
+		/* Ground may have changed while we were off */
+		bHasTraceResults = false;
+		SetComponentTickEnabled(true);
+	}
+}
+
+
+float UShooterFootIKComponent::GetGroundZ() const
+{
+	const ACharacter* Character = Cast<ACharacter>(GetOwner());
+	const UCapsuleComponent* Capsule = Character ? Character->GetCapsuleComponent() : nullptr;
+	const float HalfHeight = Capsule ? Capsule->GetScaledCapsuleHalfHeight() : 0.0f;
+
+	return GetOwner()->GetActorLocation().Z - HalfHeight;
+}
+
+
+void UShooterFootIKComponent::TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction)
+{
+	Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
+
+	Alpha = FMath::FInterpConstantTo(Alpha, bIKEnabled ? 1.0f : 0.0f, DeltaTime, BlendSpeed);
+
+	if (!bIKEnabled && Alpha <= 0.0f)
+	{
+		for (FFoot& Foot : Feet)
+		{
+			Foot.Offset = Foot.TargetOffset = 0.0f;
+			Foot.Rotation = Foot.TargetRotation = FRotator::ZeroRotator;
+		}
+		HipOffset = 0.0f;
+
+		SetComponentTickEnabled(false);
+		return;
+	}
+
+	/* Keep the feet where the animation puts them in the air */
+	const ACharacter* Character = Cast<ACharacter>(GetOwner());
+	const bool bFalling = Character && Character->GetCharacterMovement() && Character->GetCharacterMovement()->IsFalling();
+
+	if (bIKEnabled && !bFalling)
+	{
+		/* Standing still on the same spot, the ground under the feet hasn't changed */
+		const bool bStationary = bHasTraceResults
+			&& GetOwner()->GetVelocity().SizeSquared() < FMath::Square(StationarySpeed)
+			&& FVector::DistSquared(GetOwner()->GetActorLocation(), LastTraceLocation) < 1.0f;
+
+		if (!bStationary)
+		{
+			RequestTraces();
+		}
+	}
+
+	for (FFoot& Foot : Feet)
+	{
+		const float TargetOffset = bFalling ? 0.0f : Foot.TargetOffset;
+		const FRotator TargetRotation = bFalling ? FRotator::ZeroRotator : Foot.TargetRotation;
+
+		Foot.Offset = FMath::FInterpTo(Foot.Offset, TargetOffset, DeltaTime, InterpSpeed);
+		Foot.Rotation = FMath::RInterpTo(Foot.Rotation, TargetRotation, DeltaTime, InterpSpeed);
+	}
+
+	HipOffset = FMath::Min3(Feet[0].Offset, Feet[1].Offset, 0.0f);
+}
+
+
+void UShooterFootIKComponent::RequestTraces()
+{
+	UWorld* World = GetWorld();
+	const float GroundZ = GetGroundZ();
+
+	FCollisionQueryParams QueryParams(SCENE_QUERY_STAT(ShooterFootIK), false, GetOwner());
+
+	for (int32 i = 0; i < UE_ARRAY_COUNT(Feet); i++)
+	{
+		FFoot& Foot = Feet[i];
+
+		/* Previous trace hasn't come back yet, its result is still one frame ahead of us */
+		if (Foot.bTracePending)
+		{
+			continue;
+		}
+
+		const FVector FootLocation = SkeletalMesh->GetSocketLocation(Foot.Socket);
+		const FVector TraceStart(FootLocation.X, FootLocation.Y, GroundZ + TraceUpDistance);
+		const FVector TraceEnd(FootLocation.X, FootLocation.Y, GroundZ - TraceDownDistance);
+
+		World->AsyncLineTraceByChannel(EAsyncTraceType::Single, TraceStart, TraceEnd, ECC_Visibility, QueryParams,
+			FCollisionResponseParams::DefaultResponseParam, &TraceDelegate, i);
+		Foot.bTracePending = true;
+
+		INC_DWORD_STAT(STAT_FootIKTraces);
+	}
+
+	LastTraceLocation = GetOwner()->GetActorLocation();
+}
+
+
+void UShooterFootIKComponent::OnTraceCompleted(const FTraceHandle& Handle, FTraceDatum& Data)
+{
+	if (Data.UserData >= (uint32)UE_ARRAY_COUNT(Feet))
+	{
+		return;
+	}
+
+	FFoot& Foot = Feet[Data.UserData];
+	Foot.bTracePending = false;
+	bHasTraceResults = true;
+
+	const FHitResult* BlockingHit = Data.OutHits.FindByPredicate([](const FHitResult& Hit) { return Hit.bBlockingHit; });
+	if (BlockingHit == nullptr)
+	{
+		Foot.TargetOffset = 0.0f;
+		Foot.TargetRotation = FRotator::ZeroRotator;
+		return;
+	}
+
+	Foot.TargetOffset = BlockingHit->ImpactPoint.Z - GetGroundZ();
+
+	/* Align the foot with the slope under it */
+	const FVector& Normal = BlockingHit->ImpactNormal;
+	Foot.TargetRotation = FRotator(-FMath::RadiansToDegrees(FMath::Atan2(Normal.X, Normal.Z)), 0.0f, FMath::RadiansToDegrees(FMath::Atan2(Normal.Y, Normal.Z)));
+}
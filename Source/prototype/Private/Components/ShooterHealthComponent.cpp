@@ -42,7 +42,7 @@ void UShooterHealthComponent::OnRep_Health(float OldHealth)
 {
 	float Damage = Health - OldHealth;
 
-	OnHealthChanged.Broadcast(this, Health, Damage, nullptr, nullptr, nullptr);
+	BroadcastHealthChanged(Damage, nullptr, nullptr, nullptr);
 }
 
 void UShooterHealthComponent::HandleTakeAnyDamage(AActor* DamagedActor, float Damage, const class UDamageType* DamageType, class AController* InstigatedBy, AActor* DamageCauser)
@@ -63,7 +63,7 @@ void UShooterHealthComponent::HandleTakeAnyDamage(AActor* DamagedActor, float Da
 
 	bIsDead = Health <= 0.0f;
 
-	OnHealthChanged.Broadcast(this, Health, Damage, DamageType, InstigatedBy, DamageCauser);
+	BroadcastHealthChanged(Damage, DamageType, InstigatedBy, DamageCauser);
 
 	if (bIsDead)
 	{
@@ -93,7 +93,31 @@ void UShooterHealthComponent::Heal(float HealAmount)
 
 	UE_LOG(LogTemp, Log, TEXT("Health Changed: %s (+%s)"), *FString::SanitizeFloat(Health), *FString::SanitizeFloat(HealAmount));
 
-	OnHealthChanged.Broadcast(this, Health, -HealAmount, nullptr, nullptr, nullptr);
+	BroadcastHealthChanged(-HealAmount, nullptr, nullptr, nullptr);
+}
+
+
+void UShooterHealthComponent::ResetHealth()
+{
+	const float OldHealth = Health;
+
+	Health = DefaultHealth;
+	bIsDead = false;
+
+	BroadcastHealthChanged(OldHealth - Health, nullptr, nullptr, nullptr);
+}
+
+
+void UShooterHealthComponent::BroadcastHealthChanged(float HealthDelta, const class UDamageType* DamageType, class AController* InstigatedBy, AActor* DamageCauser)
+{
+	const FShooterHealthChange Change = { this, Health, HealthDelta, DamageType, InstigatedBy, DamageCauser };
+	OnHealthChangedNative.Broadcast(Change);
+
+	/* Dynamic dispatch goes through reflection, skip building its parameters when nothing listens */
+	if (OnHealthChanged.IsBound())
+	{
+		OnHealthChanged.Broadcast(this, Health, HealthDelta, DamageType, InstigatedBy, DamageCauser);
+	}
 }
 
 bool UShooterHealthComponent::IsFriendly(AActor* ActorA, AActor* ActorB)
@@ -124,3 +148,53 @@ void UShooterHealthComponent::GetLifetimeReplicatedProps(TArray<FLifetimePropert
 }
 
 
+void UShooterHealthBenchmarkListener::OnHealthChangedDynamic(UShooterHealthComponent* HealthComp, float Health, float HealthDelta, const class UDamageType* DamageType,
+	class AController* InstigatedBy, AActor* DamageCauser)
+{
+	HealthSum += Health;
+}
+
+
+void UShooterHealthBenchmarkListener::OnHealthChangedNative(const FShooterHealthChange& Change)
+{
+	HealthSum += Change.Health;
+}
+
+
+static void RunHealthDelegateBenchmark(const TArray<FString>& Args)
+{
+	const int32 NumEvents = Args.Num() > 0 ? FMath::Max(1, FCString::Atoi(*Args[0])) : 100000;
+
+	UShooterHealthBenchmarkListener* Listener = NewObject<UShooterHealthBenchmarkListener>();
+	Listener->HealthSum = 0.0f;
+
+	FOnHealthChangedSignature DynamicDelegate;
+	DynamicDelegate.AddDynamic(Listener, &UShooterHealthBenchmarkListener::OnHealthChangedDynamic);
+
+	FOnHealthChangedNative NativeDelegate;
+	NativeDelegate.AddUObject(Listener, &UShooterHealthBenchmarkListener::OnHealthChangedNative);
+
+	double StartTime = FPlatformTime::Seconds();
+	for (int32 i = 0; i < NumEvents; i++)
+	{
+		DynamicDelegate.Broadcast(nullptr, (float)i, 1.0f, nullptr, nullptr, nullptr);
+	}
+	const double DynamicCost = (FPlatformTime::Seconds() - StartTime) * 1000000000.0 / NumEvents;
+
+	StartTime = FPlatformTime::Seconds();
+	for (int32 i = 0; i < NumEvents; i++)
+	{
+		const FShooterHealthChange Change = { nullptr, (float)i, 1.0f, nullptr, nullptr, nullptr };
+		NativeDelegate.Broadcast(Change);
+	}
+	const double NativeCost = (FPlatformTime::Seconds() - StartTime) * 1000000000.0 / NumEvents;
+
+	UE_LOG(LogTemp, Log, TEXT("Health delegate benchmark, %d events: dynamic %.1f ns/event, native %.1f ns/event (checksum %f)"),
+		NumEvents, DynamicCost, NativeCost, Listener->HealthSum);
+}
+
+FAutoConsoleCommandWithArgs HealthDelegateBenchmarkCommand(
+	TEXT("COOP.Health.DelegateBenchmark"),
+	TEXT("Broadcast NumEvents (default 100000) health changes to one listener through the dynamic and the native delegate"),
+	FConsoleCommandWithArgsDelegate::CreateStatic(&RunHealthDelegateBenchmark),
+	ECVF_Cheat);
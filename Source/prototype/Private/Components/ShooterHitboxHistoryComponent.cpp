@@ -0,0 +1,403 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Components/ShooterHitboxHistoryComponent.h"
+#include "Components/SkeletalMeshComponent.h"
+#include "PhysicsEngine/PhysicsAsset.h"
+#include "PhysicsEngine/SkeletalBodySetup.h"
+#include "GameFramework/Actor.h"
+#include "Engine/World.h"
+#include "Subsystems/ShooterLagCompensationSubsystem.h"
+#include "../prototype.h"
+
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Server Poses Awake"), STAT_ServerPosesAwake, STATGROUP_Prototype);
+
+static int32 ServerAnimSleep = 1;
+
+FAutoConsoleVariableRef CVARServerAnimSleep(
+	TEXT("COOP.ServerAnim.Sleep"),
+	ServerAnimSleep,
+	TEXT("Dedicated server evaluates character poses at a reduced rate outside of combat (applies to characters spawned afterwards)"),
+	ECVF_Default);
+
+static float ServerAnimIdleInterval = 0.25f;
+
+FAutoConsoleVariableRef CVARServerAnimIdleInterval(
+	TEXT("COOP.ServerAnim.IdleInterval"),
+	ServerAnimIdleInterval,
+	TEXT("Seconds between pose evaluations of sleeping meshes on a dedicated server"),
+	ECVF_Default);
+
+
+UShooterHitboxHistoryComponent::UShooterHitboxHistoryComponent()
+{
+	PrimaryComponentTick.bCanEverTick = true;
+	/* Record after animation and physics have moved the bones for this frame */
+	PrimaryComponentTick.TickGroup = TG_PostPhysics;
+
+	MaxFrames = 32;
+	SampleInterval = 1.0f / 60.0f;
+
+	NewestFrame = INDEX_NONE;
+	NumRecordedFrames = 0;
+
+	bPoseSleepEnabled = false;
+	bPoseAwake = true;
+	PoseAwakeUntil = 0.0f;
+	LastPoseTickTime = 0.0f;
+}
+
+
+void UShooterHitboxHistoryComponent::SetHitboxes(const TArray<FShooterHitbox>& NewHitboxes)
+{
+	Hitboxes = NewHitboxes;
+}
+
+
+void UShooterHitboxHistoryComponent::BeginPlay()
+{
+	Super::BeginPlay();
+
+	AActor* MyOwner = GetOwner();
+	SkeletalMesh = MyOwner->FindComponentByClass<USkeletalMeshComponent>();
+
+	/* Clients need the body surfaces for impact effects */
+	BuildBodySurfaces();
+
+	/* History is only needed where shots are validated */
+	if (GetOwnerRole() != ROLE_Authority)
+	{
+		SetComponentTickEnabled(false);
+		return;
+	}
+
+	/* Unrendered meshes only tick their pose by default, which leaves the bones we record where they were */
+	if (SkeletalMesh)
+	{
+		SkeletalMesh->VisibilityBasedAnimTickOption = EVisibilityBasedAnimTickOption::AlwaysTickPoseAndRefreshBones;
+	}
+
+	const int32 NumHitboxes = Hitboxes.Num();
+	StartBoneIndices.SetNum(NumHitboxes);
+	EndBoneIndices.SetNum(NumHitboxes);
+	Radii.SetNum(NumHitboxes);
+
+	for (int32 i = 0; i < NumHitboxes; i++)
+	{
+		const FShooterHitbox& Hitbox = Hitboxes[i];
+
+		StartBoneIndices[i] = (SkeletalMesh && Hitbox.BoneName != NAME_None) ? SkeletalMesh->GetBoneIndex(Hitbox.BoneName) : INDEX_NONE;
+		EndBoneIndices[i] = (SkeletalMesh && Hitbox.EndBoneName != NAME_None) ? SkeletalMesh->GetBoneIndex(Hitbox.EndBoneName) : INDEX_NONE;
+
+		Radii[i] = Hitbox.Radius;
+		if (Radii[i] <= 0.0f)
+		{
+			/* Hitbox without a radius covers the root component */
+			USceneComponent* Root = MyOwner->GetRootComponent();
+			Radii[i] = Root ? Root->Bounds.SphereRadius : 0.0f;
+		}
+	}
+
+	/* Allocate the whole ring up front, recording never allocates */
+	SegmentHistory.SetNumZeroed(MaxFrames * NumHitboxes * 2);
+	FrameTimes.SetNumZeroed(MaxFrames);
+	FrameBounds.SetNumZeroed(MaxFrames);
+	NewestFrame = INDEX_NONE;
+	NumRecordedFrames = 0;
+
+	LastPoseTickTime = GetWorld()->GetTimeSeconds();
+	RecordFrame(LastPoseTickTime);
+
+	/* Listen servers render their meshes anyway */
+	if (SkeletalMesh && ServerAnimSleep && GetNetMode() == NM_DedicatedServer)
+	{
+		bPoseSleepEnabled = true;
+		INC_DWORD_STAT(STAT_ServerPosesAwake);
+		SetPoseAwake(false);
+	}
+
+	UShooterLagCompensationSubsystem* LagCompensation = GetWorld()->GetSubsystem<UShooterLagCompensationSubsystem>();
+	if (LagCompensation)
+	{
+		LagCompensation->RegisterHistory(this);
+	}
+}
+
+
+void UShooterHitboxHistoryComponent::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	UShooterLagCompensationSubsystem* LagCompensation = GetWorld()->GetSubsystem<UShooterLagCompensationSubsystem>();
+	if (LagCompensation)
+	{
+		LagCompensation->UnregisterHistory(this);
+	}
+
+	if (bPoseSleepEnabled && bPoseAwake)
+	{
+		DEC_DWORD_STAT(STAT_ServerPosesAwake);
+	}
+
+	Super::EndPlay(EndPlayReason);
+}
+
+
+void UShooterHitboxHistoryComponent::WakePose(float Time)
+{
+	if (!bPoseSleepEnabled)
+	{
+		return;
+	}
+
+	PoseAwakeUntil = FMath::Max(PoseAwakeUntil, Time);
+	if (!bPoseAwake)
+	{
+		SetPoseAwake(true);
+
+		/* The shot that woke us is judged before the mesh ticks again, catch the pose up to now and record it */
+		const float Now = GetWorld()->GetTimeSeconds();
+		if (SkeletalMesh->bRegistered && !SkeletalMesh->PoseTickedThisFrame())
+		{
+			SkeletalMesh->TickAnimation(Now - LastPoseTickTime, false);
+			SkeletalMesh->RefreshBoneTransforms();
+			LastPoseTickTime = Now;
+		}
+		RecordFrame(Now);
+	}
+}
+
+
+void UShooterHitboxHistoryComponent::ClearHistory()
+{
+	NewestFrame = INDEX_NONE;
+	NumRecordedFrames = 0;
+}
+
+
+void UShooterHitboxHistoryComponent::SetPoseAwake(bool bAwake)
+{
+	bPoseAwake = bAwake;
+
+	if (bAwake)
+	{
+		/* Also drop the remaining idle cooldown, the pose is needed from the next frame on */
+		SkeletalMesh->SetComponentTickIntervalAndCooldown(0.0f);
+		INC_DWORD_STAT(STAT_ServerPosesAwake);
+	}
+	else
+	{
+		SkeletalMesh->SetComponentTickInterval(ServerAnimIdleInterval);
+		DEC_DWORD_STAT(STAT_ServerPosesAwake);
+	}
+}
+
+
+void UShooterHitboxHistoryComponent::BuildBodySurfaces()
+{
+	BodySurfaces.Reset();
+
+	UPhysicsAsset* PhysicsAsset = SkeletalMesh ? SkeletalMesh->GetPhysicsAsset() : nullptr;
+	if (PhysicsAsset == nullptr)
+	{
+		return;
+	}
+
+	for (const USkeletalBodySetup* Body : PhysicsAsset->SkeletalBodySetups)
+	{
+		if (Body == nullptr)
+		{
+			continue;
+		}
+
+		/* Walk up the skeleton, e.g. spine_02 ends at the spine_01 hitbox and the head body at the head hitbox */
+		for (FName Bone = Body->BoneName; Bone != NAME_None; Bone = SkeletalMesh->GetParentBone(Bone))
+		{
+			const FShooterHitbox* Hitbox = Hitboxes.FindByPredicate([Bone](const FShooterHitbox& Candidate) { return Candidate.BoneName == Bone; });
+			if (Hitbox)
+			{
+				BodySurfaces.Add(Body->BoneName, Hitbox->SurfaceType);
+				break;
+			}
+		}
+	}
+}
+
+
+void UShooterHitboxHistoryComponent::TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction)
+{
+	Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
+
+	const float Now = GetWorld()->GetTimeSeconds();
+	if (SkeletalMesh && SkeletalMesh->PoseTickedThisFrame())
+	{
+		LastPoseTickTime = Now;
+	}
+
+	if (bPoseSleepEnabled && bPoseAwake && Now > PoseAwakeUntil)
+	{
+		SetPoseAwake(false);
+	}
+
+	if (NewestFrame == INDEX_NONE || Now - FrameTimes[NewestFrame] >= SampleInterval)
+	{
+		RecordFrame(Now);
+	}
+}
+
+
+void UShooterHitboxHistoryComponent::GetCurrentSegment(int32 HitboxIndex, FVector& OutStart, FVector& OutEnd) const
+{
+	const int32 StartBone = StartBoneIndices[HitboxIndex];
+	const int32 EndBone = EndBoneIndices[HitboxIndex];
+
+	OutStart = StartBone != INDEX_NONE ? SkeletalMesh->GetBoneTransform(StartBone).GetLocation() : GetOwner()->GetActorLocation();
+	OutEnd = EndBone != INDEX_NONE ? SkeletalMesh->GetBoneTransform(EndBone).GetLocation() : OutStart;
+}
+
+
+void UShooterHitboxHistoryComponent::RecordFrame(float Time)
+{
+	const int32 NumHitboxes = Hitboxes.Num();
+	if (NumHitboxes == 0 || MaxFrames <= 0)
+	{
+		return;
+	}
+
+	NewestFrame = (NewestFrame + 1) % MaxFrames;
+	NumRecordedFrames = FMath::Min(NumRecordedFrames + 1, MaxFrames);
+
+	FrameTimes[NewestFrame] = Time;
+
+	FVector* Segments = &SegmentHistory[NewestFrame * NumHitboxes * 2];
+	FBox Bounds(ForceInit);
+	float MaxRadius = 0.0f;
+	for (int32 i = 0; i < NumHitboxes; i++)
+	{
+		GetCurrentSegment(i, Segments[i * 2], Segments[i * 2 + 1]);
+
+		Bounds += Segments[i * 2];
+		Bounds += Segments[i * 2 + 1];
+		MaxRadius = FMath::Max(MaxRadius, Radii[i]);
+	}
+
+	FrameBounds[NewestFrame] = FVector4(Bounds.GetCenter(), Bounds.GetExtent().Size() + MaxRadius);
+}
+
+
+bool UShooterHitboxHistoryComponent::RewindRayTest(float Time, const FVector& TraceStart, const FVector& TraceEnd, FShooterRewindHit& OutHit) const
+{
+	const int32 NumHitboxes = Hitboxes.Num();
+	if (NumRecordedFrames == 0 || NumHitboxes == 0)
+	{
+		return false;
+	}
+
+	/* Walk back from the newest frame to find the two frames around Time */
+	int32 NewerFrame = NewestFrame;
+	int32 OlderFrame = NewestFrame;
+	for (int32 Step = 1; Step < NumRecordedFrames; Step++)
+	{
+		const int32 Candidate = (NewestFrame - Step + MaxFrames) % MaxFrames;
+		OlderFrame = Candidate;
+		if (FrameTimes[Candidate] <= Time)
+		{
+			break;
+		}
+		NewerFrame = Candidate;
+	}
+
+	float Alpha = 0.0f;
+	const float FrameSpan = FrameTimes[NewerFrame] - FrameTimes[OlderFrame];
+	if (FrameSpan > KINDA_SMALL_NUMBER)
+	{
+		Alpha = FMath::Clamp((Time - FrameTimes[OlderFrame]) / FrameSpan, 0.0f, 1.0f);
+	}
+	else if (Time >= FrameTimes[NewerFrame])
+	{
+		Alpha = 1.0f;
+	}
+
+	/* Cheap reject against the interpolated bounds, most rays miss most targets */
+	const FVector4 BoundsSphere = FMath::Lerp(FrameBounds[OlderFrame], FrameBounds[NewerFrame], Alpha);
+	if (FMath::PointDistToSegmentSquared(FVector(BoundsSphere), TraceStart, TraceEnd) > FMath::Square(BoundsSphere.W))
+	{
+		return false;
+	}
+
+	const FVector* OlderSegments = &SegmentHistory[OlderFrame * NumHitboxes * 2];
+	const FVector* NewerSegments = &SegmentHistory[NewerFrame * NumHitboxes * 2];
+
+	const FVector RayDir = (TraceEnd - TraceStart).GetSafeNormal();
+
+	bool bHit = false;
+	OutHit.Distance = FLT_MAX;
+
+	for (int32 i = 0; i < NumHitboxes; i++)
+	{
+		const FVector SegStart = FMath::Lerp(OlderSegments[i * 2], NewerSegments[i * 2], Alpha);
+		const FVector SegEnd = FMath::Lerp(OlderSegments[i * 2 + 1], NewerSegments[i * 2 + 1], Alpha);
+
+		FVector OnRay;
+		FVector OnSegment;
+		FMath::SegmentDistToSegmentSafe(TraceStart, TraceEnd, SegStart, SegEnd, OnRay, OnSegment);
+
+		const float Radius = Radii[i];
+		const float DistSq = FVector::DistSquared(OnRay, OnSegment);
+		if (DistSq > FMath::Square(Radius))
+		{
+			continue;
+		}
+
+		/* Step back from the closest approach to where the ray enters the capsule */
+		const FVector ImpactPoint = OnRay - RayDir * FMath::Sqrt(FMath::Square(Radius) - DistSq);
+		const float Distance = FVector::Dist(TraceStart, ImpactPoint);
+		if (Distance < OutHit.Distance)
+		{
+			bHit = true;
+			OutHit.HitboxIndex = i;
+			OutHit.ImpactPoint = ImpactPoint;
+			OutHit.ImpactNormal = (ImpactPoint - OnSegment).GetSafeNormal();
+			OutHit.Distance = Distance;
+		}
+	}
+
+	return bHit;
+}
+
+
+FHitResult UShooterHitboxHistoryComponent::MakeHitResult(const FShooterRewindHit& RewindHit, const FVector& TraceStart, const FVector& TraceEnd) const
+{
+	UPrimitiveComponent* HitComponent = SkeletalMesh ? SkeletalMesh : Cast<UPrimitiveComponent>(GetOwner()->GetRootComponent());
+
+	FHitResult Hit(GetOwner(), HitComponent, RewindHit.ImpactPoint, RewindHit.ImpactNormal);
+	Hit.bBlockingHit = true;
+	Hit.TraceStart = TraceStart;
+	Hit.TraceEnd = TraceEnd;
+	Hit.Distance = RewindHit.Distance;
+	Hit.Time = RewindHit.Distance / FMath::Max(FVector::Dist(TraceStart, TraceEnd), KINDA_SMALL_NUMBER);
+	Hit.BoneName = Hitboxes[RewindHit.HitboxIndex].BoneName;
+
+	return Hit;
+}
+
+
+EPhysicalSurface UShooterHitboxHistoryComponent::GetSurfaceForBone(FName BoneName) const
+{
+	if (BoneName != NAME_None)
+	{
+		const TEnumAsByte<EPhysicalSurface>* BodySurface = BodySurfaces.Find(BoneName);
+		if (BodySurface)
+		{
+			return *BodySurface;
+		}
+
+		for (const FShooterHitbox& Hitbox : Hitboxes)
+		{
+			if (Hitbox.BoneName == BoneName)
+			{
+				return Hitbox.SurfaceType;
+			}
+		}
+	}
+
+	return SurfaceType_Default;
+}
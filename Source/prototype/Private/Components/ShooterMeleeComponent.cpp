@@ -0,0 +1,143 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Components/ShooterMeleeComponent.h"
+#include "Components/SkeletalMeshComponent.h"
+#include "Kismet/GameplayStatics.h"
+#include "Engine/World.h"
+#include "../prototype.h"
+
+DECLARE_CYCLE_STAT(TEXT("Melee Sweep"), STAT_MeleeSweep, STATGROUP_Prototype);
+
+
+UShooterMeleeComponent::UShooterMeleeComponent()
+{
+	/* Driven by the hit window notify, never ticks on its own */
+	PrimaryComponentTick.bCanEverTick = false;
+
+	MaxSubstepDistance = 30.0f;
+	MaxSubsteps = 4;
+
+	SwingRadius = 0.0f;
+	SwingDamage = 0.0f;
+	bSwinging = false;
+}
+
+
+void UShooterMeleeComponent::BeginSwing(USkeletalMeshComponent* TraceMesh, FName StartSocket, FName EndSocket, float Radius, float Damage, TSubclassOf<UDamageType> DamageType, AActor* DamageCauser)
+{
+	/* Damage is only dealt by the server */
+	if (TraceMesh == nullptr || GetOwnerRole() != ROLE_Authority)
+	{
+		return;
+	}
+
+	SwingMesh = TraceMesh;
+	SwingStartSocket = StartSocket;
+	SwingEndSocket = EndSocket;
+	SwingRadius = Radius;
+	SwingDamage = Damage;
+	SwingDamageType = DamageType;
+	SwingDamageCauser = DamageCauser;
+
+	SwingHitActors.Reset();
+	bSwinging = true;
+
+	GetSwingSegment(PrevSwingStart, PrevSwingEnd);
+}
+
+
+void UShooterMeleeComponent::TickSwing()
+{
+	if (!bSwinging || !SwingMesh.IsValid())
+	{
+		return;
+	}
+
+	SCOPE_CYCLE_COUNTER(STAT_MeleeSweep);
+
+	FVector CurStart;
+	FVector CurEnd;
+	GetSwingSegment(CurStart, CurEnd);
+
+	/* Split fast swings so the blade's rotation is followed instead of sweeping a straight line */
+	const float MaxTravel = FMath::Max(FVector::Dist(PrevSwingStart, CurStart), FVector::Dist(PrevSwingEnd, CurEnd));
+	const int32 NumSubsteps = FMath::Clamp(FMath::CeilToInt(MaxTravel / MaxSubstepDistance), 1, MaxSubsteps);
+
+	FVector StepStart = PrevSwingStart;
+	FVector StepEnd = PrevSwingEnd;
+	for (int32 Step = 1; Step <= NumSubsteps; Step++)
+	{
+		const float Alpha = static_cast<float>(Step) / NumSubsteps;
+		const FVector NextStart = FMath::Lerp(PrevSwingStart, CurStart, Alpha);
+		const FVector NextEnd = FMath::Lerp(PrevSwingEnd, CurEnd, Alpha);
+
+		SweepSegment(StepStart, StepEnd, NextStart, NextEnd);
+
+		StepStart = NextStart;
+		StepEnd = NextEnd;
+	}
+
+	PrevSwingStart = CurStart;
+	PrevSwingEnd = CurEnd;
+}
+
+
+void UShooterMeleeComponent::EndSwing()
+{
+	if (bSwinging)
+	{
+		/* Catch what moved through the blade since the last tick */
+		TickSwing();
+	}
+
+	bSwinging = false;
+	SwingMesh = nullptr;
+	SwingHitActors.Reset();
+}
+
+
+void UShooterMeleeComponent::GetSwingSegment(FVector& OutStart, FVector& OutEnd) const
+{
+	USkeletalMeshComponent* Mesh = SwingMesh.Get();
+
+	OutStart = Mesh->GetSocketLocation(SwingStartSocket);
+	OutEnd = SwingEndSocket != NAME_None ? Mesh->GetSocketLocation(SwingEndSocket) : OutStart;
+}
+
+
+void UShooterMeleeComponent::SweepSegment(const FVector& FromStart, const FVector& FromEnd, const FVector& ToStart, const FVector& ToEnd)
+{
+	AActor* MyOwner = GetOwner();
+
+	/* Capsule along the segment at its destination, swept from the segment's previous center */
+	const FVector Axis = ToEnd - ToStart;
+	const float HalfLength = Axis.Size() * 0.5f;
+	const FQuat Rotation = HalfLength > KINDA_SMALL_NUMBER ? FRotationMatrix::MakeFromZ(Axis).ToQuat() : FQuat::Identity;
+	const FCollisionShape Shape = FCollisionShape::MakeCapsule(SwingRadius, HalfLength + SwingRadius);
+
+	const FVector FromCenter = (FromStart + FromEnd) * 0.5f;
+	const FVector ToCenter = (ToStart + ToEnd) * 0.5f;
+
+	FCollisionQueryParams QueryParams(SCENE_QUERY_STAT(ShooterMeleeSweep), false, MyOwner);
+	QueryParams.AddIgnoredActor(SwingDamageCauser.Get());
+
+	/* Pawns only, melee has nothing to do with world geometry */
+	TArray<FHitResult> SweepHits;
+	GetWorld()->SweepMultiByObjectType(SweepHits, FromCenter, ToCenter, Rotation, FCollisionObjectQueryParams(ECC_Pawn), Shape, QueryParams);
+
+	const FVector SwingDirection = (ToCenter - FromCenter).GetSafeNormal();
+
+	for (const FHitResult& Hit : SweepHits)
+	{
+		AActor* HitActor = Hit.GetActor();
+		if (HitActor == nullptr || SwingHitActors.Contains(HitActor))
+		{
+			continue;
+		}
+
+		SwingHitActors.Add(HitActor);
+
+		UGameplayStatics::ApplyPointDamage(HitActor, SwingDamage, SwingDirection, Hit, MyOwner->GetInstigatorController(), SwingDamageCauser.Get(), SwingDamageType);
+	}
+}
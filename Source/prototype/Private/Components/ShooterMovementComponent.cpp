@@ -3,24 +3,197 @@
 
 #include "Components/ShooterMovementComponent.h"
 #include "ShooterCharacter.h"
+#include "Components/ShooterAttributeComponent.h"
+
+
+UShooterMovementComponent::UShooterMovementComponent()
+{
+	bWantsToSprint = false;
+	bWantsToTarget = false;
+
+	ShooterOwner = nullptr;
+	OwnerAttributes = nullptr;
+}
+
+
+void UShooterMovementComponent::SetUpdatedComponent(USceneComponent* NewUpdatedComponent)
+{
+	Super::SetUpdatedComponent(NewUpdatedComponent);
+
+	ShooterOwner = Cast<AShooterCharacter>(PawnOwner);
+	OwnerAttributes = ShooterOwner ? ShooterOwner->GetAttributeComp() : nullptr;
+}
+
 
 float UShooterMovementComponent::GetMaxSpeed() const
 {
 	float MaxSpeed = Super::GetMaxSpeed();
 
-	const AShooterCharacter* CharOwner = Cast<AShooterCharacter>(PawnOwner);
-	if (CharOwner)
+	if (ShooterOwner)
 	{
 		// Slow down during targeting or crouching
-		if (CharOwner->IsTargeting() && !IsCrouching())
+		if (bWantsToTarget && !IsCrouching())
 		{
-			MaxSpeed *= CharOwner->GetTargetingSpeedModifier();
+			MaxSpeed *= ShooterOwner->GetTargetingSpeedModifier();
 		}
-		else if (CharOwner->IsSprinting())
+		else if (IsSprinting())
 		{
-			MaxSpeed *= CharOwner->GetSprintingSpeedModifier();
+			MaxSpeed *= ShooterOwner->GetSprintingSpeedModifier();
 		}
 	}
 
+	/* Cached, only re-aggregated when a modifier changed */
+	if (OwnerAttributes)
+	{
+		MaxSpeed *= OwnerAttributes->GetValue(EShooterAttribute::MoveSpeed);
+	}
+
 	return MaxSpeed;
-}
\ No newline at end of file
+}
+
+
+bool UShooterMovementComponent::IsSprinting() const
+{
+	if (!bWantsToSprint || bWantsToTarget || Velocity.IsZero() || UpdatedComponent == nullptr)
+	{
+		return false;
+	}
+
+	// Don't allow sprint while strafing sideways or standing still, same threshold as AShooterCharacter::IsSprinting
+	return FVector::DotProduct(Velocity.GetSafeNormal2D(), UpdatedComponent->GetForwardVector()) > 0.8f;
+}
+
+
+void UShooterMovementComponent::SetWantsToSprint(bool bNewWantsToSprint)
+{
+	bWantsToSprint = bNewWantsToSprint;
+}
+
+
+void UShooterMovementComponent::SetWantsToTarget(bool bNewWantsToTarget)
+{
+	bWantsToTarget = bNewWantsToTarget;
+}
+
+
+void UShooterMovementComponent::UpdateFromCompressedFlags(uint8 Flags)
+{
+	Super::UpdateFromCompressedFlags(Flags);
+
+	bWantsToSprint = (Flags & FSavedMove_Character::FLAG_Custom_0) != 0;
+	bWantsToTarget = (Flags & FSavedMove_Character::FLAG_Custom_1) != 0;
+
+	/* The server mirrors the client's state onto the character, where it replicates to the other clients */
+	if (CharacterOwner && CharacterOwner->GetLocalRole() == ROLE_Authority)
+	{
+		AShooterCharacter* CharOwner = Cast<AShooterCharacter>(CharacterOwner);
+		if (CharOwner)
+		{
+			CharOwner->ApplyMoveFlags(bWantsToSprint, bWantsToTarget);
+		}
+	}
+}
+
+
+FNetworkPredictionData_Client* UShooterMovementComponent::GetPredictionData_Client() const
+{
+	if (ClientPredictionData == nullptr)
+	{
+		UShooterMovementComponent* MutableThis = const_cast<UShooterMovementComponent*>(this);
+		MutableThis->ClientPredictionData = new FNetworkPredictionData_Client_Shooter(*this);
+	}
+
+	return ClientPredictionData;
+}
+
+
+bool UShooterMovementComponent::ClientUpdatePositionAfterServerUpdate()
+{
+	/* Replaying saved moves overwrites the flags with each move's, keep what the player is holding right now */
+	const bool bRealWantsToSprint = bWantsToSprint;
+	const bool bRealWantsToTarget = bWantsToTarget;
+
+	const bool bResult = Super::ClientUpdatePositionAfterServerUpdate();
+
+	bWantsToSprint = bRealWantsToSprint;
+	bWantsToTarget = bRealWantsToTarget;
+
+	return bResult;
+}
+
+
+void FSavedMove_Shooter::Clear()
+{
+	Super::Clear();
+
+	bSavedWantsToSprint = false;
+	bSavedWantsToTarget = false;
+}
+
+
+uint8 FSavedMove_Shooter::GetCompressedFlags() const
+{
+	uint8 Flags = Super::GetCompressedFlags();
+
+	if (bSavedWantsToSprint)
+	{
+		Flags |= FLAG_Custom_0;
+	}
+	if (bSavedWantsToTarget)
+	{
+		Flags |= FLAG_Custom_1;
+	}
+
+	return Flags;
+}
+
+
+bool FSavedMove_Shooter::CanCombineWith(const FSavedMovePtr& NewMove, ACharacter* InCharacter, float MaxDelta) const
+{
+	const FSavedMove_Shooter* NewShooterMove = static_cast<const FSavedMove_Shooter*>(NewMove.Get());
+	if (bSavedWantsToSprint != NewShooterMove->bSavedWantsToSprint || bSavedWantsToTarget != NewShooterMove->bSavedWantsToTarget)
+	{
+		return false;
+	}
+
+	return Super::CanCombineWith(NewMove, InCharacter, MaxDelta);
+}
+
+
+void FSavedMove_Shooter::SetMoveFor(ACharacter* C, float InDeltaTime, FVector const& NewAccel, FNetworkPredictionData_Client_Character& ClientData)
+{
+	Super::SetMoveFor(C, InDeltaTime, NewAccel, ClientData);
+
+	const UShooterMovementComponent* MoveComp = Cast<UShooterMovementComponent>(C->GetCharacterMovement());
+	if (MoveComp)
+	{
+		bSavedWantsToSprint = MoveComp->bWantsToSprint;
+		bSavedWantsToTarget = MoveComp->bWantsToTarget;
+	}
+}
+
+
+void FSavedMove_Shooter::PrepMoveFor(ACharacter* C)
+{
+	Super::PrepMoveFor(C);
+
+	/* Replays after a correction run with the state each move was made with */
+	UShooterMovementComponent* MoveComp = Cast<UShooterMovementComponent>(C->GetCharacterMovement());
+	if (MoveComp)
+	{
+		MoveComp->bWantsToSprint = bSavedWantsToSprint;
+		MoveComp->bWantsToTarget = bSavedWantsToTarget;
+	}
+}
+
+
+FNetworkPredictionData_Client_Shooter::FNetworkPredictionData_Client_Shooter(const UCharacterMovementComponent& ClientMovement)
+	: Super(ClientMovement)
+{
+}
+
+
+FSavedMovePtr FNetworkPredictionData_Client_Shooter::AllocateNewMove()
+{
+	return FSavedMovePtr(new FSavedMove_Shooter());
+}
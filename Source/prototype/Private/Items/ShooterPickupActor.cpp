@@ -40,7 +40,9 @@ void AShooterPickupActor::OnUsed(APawn* InstigatorPawn)
 {
 	Super::OnUsed(InstigatorPawn);
 
+#if !UE_SERVER
 	UGameplayStatics::PlaySoundAtLocation(this, PickupSound, GetActorLocation());
+#endif
 
 	bIsActive = false;
 	OnPickedUp();
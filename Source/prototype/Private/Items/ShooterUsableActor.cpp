@@ -3,6 +3,7 @@
 
 #include "Items/ShooterUsableActor.h"
 #include "Components/StaticMeshComponent.h"
+#include "Subsystems/ShooterUsableSubsystem.h"
 
 // Sets default values
 AShooterUsableActor::AShooterUsableActor()
@@ -11,6 +12,28 @@ AShooterUsableActor::AShooterUsableActor()
 	RootComponent = MeshComp;
 }
 
+void AShooterUsableActor::BeginPlay()
+{
+	Super::BeginPlay();
+
+	UShooterUsableSubsystem* Usables = GetWorld()->GetSubsystem<UShooterUsableSubsystem>();
+	if (Usables)
+	{
+		Usables->RegisterUsable(this);
+	}
+}
+
+void AShooterUsableActor::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	UShooterUsableSubsystem* Usables = GetWorld()->GetSubsystem<UShooterUsableSubsystem>();
+	if (Usables)
+	{
+		Usables->UnregisterUsable(this);
+	}
+
+	Super::EndPlay(EndPlayReason);
+}
+
 void AShooterUsableActor::OnUsed(APawn* InstigatorPawn)
 {
 	// Nothing to do here...
@@ -19,14 +42,18 @@ void AShooterUsableActor::OnUsed(APawn* InstigatorPawn)
 
 void AShooterUsableActor::OnBeginFocus()
 {
+#if !UE_SERVER
 	// Used by custom PostProcess to render outlines
 	MeshComp->SetRenderCustomDepth(true);
+#endif
 }
 
 
 void AShooterUsableActor::OnEndFocus()
 {
+#if !UE_SERVER
 	// Used by custom PostProcess to render outlines
 	MeshComp->SetRenderCustomDepth(false);
+#endif
 }
 
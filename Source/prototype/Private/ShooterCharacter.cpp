@@ -8,12 +8,43 @@
 #include "Components/CapsuleComponent.h"
 #include "../prototype.h"
 #include "Components/ShooterHealthComponent.h"
+#include "Components/ShooterHitboxHistoryComponent.h"
+#include "Components/ShooterMeleeComponent.h"
+#include "Components/ShooterFootIKComponent.h"
+#include "Components/ShooterAttributeComponent.h"
 #include "Components/ShooterMovementComponent.h"
 #include "Components/PawnNoiseEmitterComponent.h"
 #include "ShooterWeapon.h"
 #include "Net/UnrealNetwork.h"
 #include "Items/ShooterUsableActor.h"
 #include "Items/ShooterWeaponPickup.h"
+#include "Subsystems/ShooterUsableSubsystem.h"
+#include "Subsystems/ShooterLagCompensationSubsystem.h"
+
+
+static float ServerAnimMeleeWakeRadius = 400.0f;
+
+FAutoConsoleVariableRef CVARServerAnimMeleeWakeRadius(
+	TEXT("COOP.ServerAnim.MeleeWakeRadius"),
+	ServerAnimMeleeWakeRadius,
+	TEXT("Characters within this distance of a character playing a montage evaluate their pose at full rate on a dedicated server"),
+	ECVF_Default);
+
+static float ServerAnimArmedWakeRadius = 2000.0f;
+
+FAutoConsoleVariableRef CVARServerAnimArmedWakeRadius(
+	TEXT("COOP.ServerAnim.ArmedWakeRadius"),
+	ServerAnimArmedWakeRadius,
+	TEXT("Characters within this distance of a character holding a weapon evaluate their pose at full rate on a dedicated server (0 to disable)"),
+	ECVF_Default);
+
+static float ServerAnimArmedWakeInterval = 0.5f;
+
+FAutoConsoleVariableRef CVARServerAnimArmedWakeInterval(
+	TEXT("COOP.ServerAnim.ArmedWakeInterval"),
+	ServerAnimArmedWakeInterval,
+	TEXT("Seconds between two wakes around an armed character, keep below COOP.ServerAnim.AwakeTime"),
+	ECVF_Default);
 
 // Sets default values
 AShooterCharacter::AShooterCharacter(const class FObjectInitializer& ObjectInitializer)
@@ -30,13 +61,39 @@ AShooterCharacter::AShooterCharacter(const class FObjectInitializer& ObjectIniti
 
 	GetCapsuleComponent()->SetCollisionResponseToChannel(COLLISION_WEAPON, ECR_Ignore);
 
+	/* Hitscan shots hit the physics asset bodies of the mesh, not the capsule */
+	GetCapsuleComponent()->SetCollisionResponseToChannel(COLLISION_HITBOX, ECR_Ignore);
+	GetMesh()->SetCollisionResponseToChannel(COLLISION_HITBOX, ECR_Block);
+
 	HealthComp = CreateDefaultSubobject<UShooterHealthComponent>(TEXT("HealthComp"));
 
+	/* Bone-to-bone capsules matching the character skeleton, the head carries the headshot surface */
+	HitboxHistoryComp = CreateDefaultSubobject<UShooterHitboxHistoryComponent>(TEXT("HitboxHistoryComp"));
+	HitboxHistoryComp->SetHitboxes({
+		FShooterHitbox("head", NAME_None, 14.0f, SURFACE_FLESHVULNERABLE),
+		FShooterHitbox("spine_01", "neck_01", 20.0f, SURFACE_FLESHDEFAULT),
+		FShooterHitbox("pelvis", "spine_01", 18.0f, SURFACE_FLESHDEFAULT),
+		FShooterHitbox("upperarm_l", "lowerarm_l", 7.0f, SURFACE_FLESHDEFAULT),
+		FShooterHitbox("lowerarm_l", "hand_l", 6.0f, SURFACE_FLESHDEFAULT),
+		FShooterHitbox("upperarm_r", "lowerarm_r", 7.0f, SURFACE_FLESHDEFAULT),
+		FShooterHitbox("lowerarm_r", "hand_r", 6.0f, SURFACE_FLESHDEFAULT),
+		FShooterHitbox("thigh_l", "calf_l", 10.0f, SURFACE_FLESHDEFAULT),
+		FShooterHitbox("calf_l", "foot_l", 8.0f, SURFACE_FLESHDEFAULT),
+		FShooterHitbox("thigh_r", "calf_r", 10.0f, SURFACE_FLESHDEFAULT),
+		FShooterHitbox("calf_r", "foot_r", 8.0f, SURFACE_FLESHDEFAULT)
+	});
+
+	MeleeComp = CreateDefaultSubobject<UShooterMeleeComponent>(TEXT("MeleeComp"));
+
 	CameraComp = CreateDefaultSubobject<UCameraComponent>(TEXT("CameraComp"));
 	CameraComp->SetupAttachment(SpringArmComp);
 
 	NoiseEmitterComp = CreateDefaultSubobject<UPawnNoiseEmitterComponent>(TEXT("NoiseEmitterComp"));
 
+	FootIKComp = CreateDefaultSubobject<UShooterFootIKComponent>(TEXT("FootIKComp"));
+
+	AttributeComp = CreateDefaultSubobject<UShooterAttributeComponent>(TEXT("AttributeComp"));
+
 	ZoomedFOV = 65.0f;
 	ZoomInterpSpeed = 20;
 
@@ -47,7 +104,14 @@ AShooterCharacter::AShooterCharacter(const class FObjectInitializer& ObjectIniti
 
 	MaxUseDistance = 500;
 	DropWeaponMaxDistance = 100;
-	bHasNewFocus = true;
+	FocusCheckInterval = 0.1f;
+	LastFocusCheckTime = -BIG_NUMBER;
+	bFocusTracePending = false;
+	LastPoseWakeTime = -BIG_NUMBER;
+
+	Significance = EShooterSignificance::High;
+	bDeathApplied = false;
+	CorpseLifeSpan = 10.0f;
 	TargetingSpeedModifier = 0.5f;
 	SprintingSpeedModifier = 2.5f;
 }
@@ -68,27 +132,23 @@ void AShooterCharacter::SetSprinting(bool NewSprinting)
 
 	bWantsToRun = NewSprinting;
 
-	if (bIsCrouched)
+	UShooterMovementComponent* MoveComp = Cast<UShooterMovementComponent>(GetCharacterMovement());
+	if (MoveComp)
 	{
-		UnCrouch();
+		MoveComp->SetWantsToSprint(NewSprinting);
 	}
 
-	if (!HasAuthority())
+	if (bIsCrouched)
 	{
-		ServerSetSprinting(NewSprinting);
+		UnCrouch();
 	}
 }
 
 
-void AShooterCharacter::ServerSetSprinting_Implementation(bool NewSprinting)
+void AShooterCharacter::ApplyMoveFlags(bool NewWantsToRun, bool NewTargeting)
 {
-	SetSprinting(NewSprinting);
-}
-
-
-bool AShooterCharacter::ServerSetSprinting_Validate(bool NewSprinting)
-{
-	return true;
+	bWantsToRun = NewWantsToRun;
+	bIsTargeting = NewTargeting;
 }
 
 
@@ -119,25 +179,14 @@ void AShooterCharacter::SetTargeting(bool NewTargeting)
 {
 	bIsTargeting = NewTargeting;
 
-	if (!HasAuthority())
+	UShooterMovementComponent* MoveComp = Cast<UShooterMovementComponent>(GetCharacterMovement());
+	if (MoveComp)
 	{
-		ServerSetTargeting(NewTargeting);
+		MoveComp->SetWantsToTarget(NewTargeting);
 	}
 }
 
 
-void AShooterCharacter::ServerSetTargeting_Implementation(bool NewTargeting)
-{
-	SetTargeting(NewTargeting);
-}
-
-
-bool AShooterCharacter::ServerSetTargeting_Validate(bool NewTargeting)
-{
-	return true;
-}
-
-
 
 bool AShooterCharacter::IsTargeting() const
 {
@@ -192,7 +241,13 @@ void AShooterCharacter::BeginPlay()
 	Super::BeginPlay();
 	
 	DefaultFOV = CameraComp->FieldOfView;
-	HealthComp->OnHealthChanged.AddDynamic(this, &AShooterCharacter::OnHealthChanged);
+	HealthComp->OnHealthChangedNative.AddUObject(this, &AShooterCharacter::OnHealthChanged);
+
+	UShooterSignificanceSubsystem* SignificanceSubsystem = GetWorld()->GetSubsystem<UShooterSignificanceSubsystem>();
+	if (SignificanceSubsystem)
+	{
+		SignificanceSubsystem->RegisterActor(this, FShooterSignificanceChanged::CreateUObject(this, &AShooterCharacter::OnSignificanceChanged));
+	}
 	
 	//if (HasAuthority()) {
 	//	// Spawn a default weapon
@@ -210,11 +265,41 @@ void AShooterCharacter::BeginPlay()
 
 void AShooterCharacter::EndPlay(const EEndPlayReason::Type EndPlayReason)
 {
+	UShooterSignificanceSubsystem* SignificanceSubsystem = GetWorld()->GetSubsystem<UShooterSignificanceSubsystem>();
+	if (SignificanceSubsystem)
+	{
+		SignificanceSubsystem->UnregisterActor(this);
+	}
+
 	Super::EndPlay(EndPlayReason);
 	DestroyInventory();
 }
 
 
+void AShooterCharacter::OnSignificanceChanged(EShooterSignificance NewSignificance)
+{
+	/* The player's own character drives the camera and focus, it always runs at full rate */
+	if (IsLocallyControlled())
+	{
+		NewSignificance = EShooterSignificance::High;
+	}
+
+	Significance = NewSignificance;
+
+	const float TickInterval = UShooterSignificanceSubsystem::GetTickInterval(NewSignificance);
+	SetActorTickInterval(TickInterval);
+
+	/* The server validates shots against the mesh pose, only clients may animate distant characters less often */
+	if (GetNetMode() != NM_DedicatedServer && !HasAuthority() && GetMesh())
+	{
+		GetMesh()->SetComponentTickInterval(TickInterval);
+	}
+
+	/* Nobody notices feet sliding on distant characters */
+	FootIKComp->SetIKEnabled(NewSignificance <= EShooterSignificance::Medium);
+}
+
+
 void AShooterCharacter::MoveForward(float Value)
 {
 	const FRotator Rotation = bIsFreelooking ? GetActorRotation() : Controller->GetControlRotation();
@@ -269,6 +354,14 @@ AShooterUsableActor* AShooterCharacter::GetUsableInView() const
 		return nullptr;
 
 	Controller->GetPlayerViewPoint(CamLoc, CamRot);
+
+	/* Nothing usable in reach, no need to trace */
+	UShooterUsableSubsystem* Usables = GetWorld()->GetSubsystem<UShooterUsableSubsystem>();
+	if (Usables == nullptr || !Usables->HasUsableInRange(CamLoc, MaxUseDistance))
+	{
+		return nullptr;
+	}
+
 	const FVector TraceStart = CamLoc;
 	const FVector Direction = CamRot.Vector();
 	const FVector TraceEnd = TraceStart + (Direction * MaxUseDistance);
@@ -386,26 +479,17 @@ void AShooterCharacter::SetIsJumping(bool NewJumping)
 
 		if (bIsJumping)
 		{
-			/* Perform the built-in Jump on the character */
+			/* Perform the built-in Jump on the character, it travels to the server in the move's jump flag */
 			Jump();
 		}
 	}
-
-	if (!HasAuthority())
-	{
-		ServerSetIsJumping(NewJumping);
-	}
 }
 
-void AShooterCharacter::ServerSetIsJumping_Implementation(bool NewJumping)
+void AShooterCharacter::OnJumped_Implementation()
 {
-	SetIsJumping(NewJumping);
-}
-
+	Super::OnJumped_Implementation();
 
-bool AShooterCharacter::ServerSetIsJumping_Validate(bool NewJumping)
-{
-	return true;
+	bIsJumping = true;
 }
 
 void AShooterCharacter::StartFire()
@@ -530,20 +614,93 @@ bool AShooterCharacter::ServerDropWeapon_Validate()
 	return true;
 }
 
-void AShooterCharacter::OnHealthChanged(UShooterHealthComponent* OwningHealthComp, float Health, float HealthDelta,
-	const class UDamageType* DamageType, class AController* InstigatedBy, AActor* DamageCauser)
+void AShooterCharacter::OnHealthChanged(const FShooterHealthChange& Change)
 {
-	if (Health <= 0.0f && !bDied)
+	if (Change.Health <= 0.0f && !bDeathApplied)
 	{
 		bDied = true;
+		bDeathApplied = true;
 
 		GetMovementComponent()->StopMovementImmediately();
 		GetCapsuleComponent()->SetCollisionEnabled(ECollisionEnabled::NoCollision);
 
 		DetachFromControllerPendingDestroy();
 
-		SetLifeSpan(10.0f);
+		if (HasAuthority())
+		{
+			UShooterPawnRecyclerSubsystem* Recycler = GetWorld()->GetSubsystem<UShooterPawnRecyclerSubsystem>();
+			if (Recycler == nullptr || !Recycler->RetirePawn(this, CorpseLifeSpan))
+			{
+				SetLifeSpan(CorpseLifeSpan);
+			}
+		}
+	}
+	else if (Change.Health > 0.0f && bDeathApplied)
+	{
+		/* Dead pawns are never healed, health only comes back when the recycler reuses us */
+		RestoreFromDeath();
+	}
+}
+
+
+void AShooterCharacter::RestoreFromDeath()
+{
+	bDeathApplied = false;
+	bDied = false;
+	bIsJumping = false;
+
+	/* Input was unbound while dead, a sprint or aim key held at death never got its release */
+	SetSprinting(false);
+	SetTargeting(false);
+
+	const AShooterCharacter* DefaultCharacter = GetClass()->GetDefaultObject<AShooterCharacter>();
+	GetCapsuleComponent()->SetCollisionEnabled(DefaultCharacter->GetCapsuleComponent()->GetCollisionEnabled());
+
+	/* Ragdolls set up in Blueprint leave the mesh simulating and detached from the capsule */
+	USkeletalMeshComponent* MeshComp = GetMesh();
+	if (MeshComp->IsSimulatingPhysics())
+	{
+		MeshComp->SetAllBodiesSimulatePhysics(false);
+		MeshComp->SetCollisionEnabled(DefaultCharacter->GetMesh()->GetCollisionEnabled());
+		MeshComp->AttachToComponent(GetCapsuleComponent(), FAttachmentTransformRules::KeepRelativeTransform);
+		MeshComp->SetRelativeLocationAndRotation(GetBaseTranslationOffset(), GetBaseRotationOffset());
 	}
+
+	StopAllAnimMontages();
+	GetCharacterMovement()->SetDefaultMovementMode();
+}
+
+
+void AShooterCharacter::StoreCorpse()
+{
+	DestroyInventory();
+
+	SetActorHiddenInGame(true);
+	SetActorEnableCollision(false);
+	SetActorTickEnabled(false);
+	GetCharacterMovement()->SetComponentTickEnabled(false);
+
+	HitboxHistoryComp->SetComponentTickEnabled(false);
+	HitboxHistoryComp->ClearHistory();
+}
+
+
+void AShooterCharacter::ResetForReuse(const FTransform& SpawnTransform)
+{
+	SetActorLocationAndRotation(SpawnTransform.GetLocation(), SpawnTransform.GetRotation(), false, nullptr, ETeleportType::ResetPhysics);
+
+	SetActorHiddenInGame(false);
+	SetActorEnableCollision(true);
+	SetActorTickEnabled(true);
+	GetCharacterMovement()->SetComponentTickEnabled(true);
+
+	HitboxHistoryComp->SetComponentTickEnabled(true);
+
+	/* Powerups of the previous life would otherwise carry over to whoever gets this pawn */
+	AttributeComp->ClearModifiers();
+
+	/* The rest comes back through OnHealthChanged, the same way it does on clients */
+	HealthComp->ResetHealth();
 }
 
 // Called every frame
@@ -557,38 +714,102 @@ void AShooterCharacter::Tick(float DeltaTime)
 
 	CameraComp->SetFieldOfView(NewFOV);
 
-	if (bWantsToRun && !IsSprinting())
+#if !UE_SERVER
+	if (Controller && Controller->IsLocalController())
 	{
-		SetSprinting(true);
+		UpdateFocus();
 	}
+#endif
 
-	if (Controller && Controller->IsLocalController())
+	if (CurrentWeapon && GetNetMode() == NM_DedicatedServer)
 	{
-		AShooterUsableActor* Usable = GetUsableInView();
+		WakeNearbyPoses();
+	}
+}
 
-		// End Focus
-		if (FocusedUsableActor != Usable)
-		{
-			if (FocusedUsableActor)
-			{
-				FocusedUsableActor->OnEndFocus();
-			}
 
-			bHasNewFocus = true;
-		}
+void AShooterCharacter::WakeNearbyPoses()
+{
+	const float Now = GetWorld()->GetTimeSeconds();
+	if (ServerAnimArmedWakeRadius <= 0.0f || Now - LastPoseWakeTime < ServerAnimArmedWakeInterval)
+	{
+		return;
+	}
 
-		// Assign new Focus
-		FocusedUsableActor = Usable;
+	LastPoseWakeTime = Now;
 
-		// Start Focus.
-		if (Usable)
-		{
-			if (bHasNewFocus)
-			{
-				Usable->OnBeginFocus();
-				bHasNewFocus = false;
-			}
-		}
+	/* Shots arrive up to a rewind window after they were fired, the targets must already be awake by then */
+	UShooterLagCompensationSubsystem* LagCompensation = GetWorld()->GetSubsystem<UShooterLagCompensationSubsystem>();
+	if (LagCompensation)
+	{
+		LagCompensation->NotifyCombatActivity(GetActorLocation(), GetActorLocation(), ServerAnimArmedWakeRadius);
+	}
+}
+
+
+void AShooterCharacter::UpdateFocus()
+{
+	const float Now = GetWorld()->GetTimeSeconds();
+	if (bFocusTracePending || Now - LastFocusCheckTime < FocusCheckInterval)
+	{
+		return;
+	}
+
+	LastFocusCheckTime = Now;
+
+	FVector CamLoc;
+	FRotator CamRot;
+	Controller->GetPlayerViewPoint(CamLoc, CamRot);
+
+	/* Most of the time nothing usable is near, and then there is nothing to trace for */
+	UShooterUsableSubsystem* Usables = GetWorld()->GetSubsystem<UShooterUsableSubsystem>();
+	if (Usables == nullptr || !Usables->HasUsableInRange(CamLoc, MaxUseDistance))
+	{
+		SetFocusedUsable(nullptr);
+		return;
+	}
+
+	if (!FocusTraceDelegate.IsBound())
+	{
+		FocusTraceDelegate.BindUObject(this, &AShooterCharacter::OnFocusTraceCompleted);
+	}
+
+	/* Same query as GetUsableInView, rough collision makes tiny objects easier to select */
+	FCollisionQueryParams TraceParams(SCENE_QUERY_STAT(TraceUsableActor), false, this);
+
+	GetWorld()->AsyncLineTraceByChannel(EAsyncTraceType::Single, CamLoc, CamLoc + CamRot.Vector() * MaxUseDistance, ECC_Visibility, TraceParams,
+		FCollisionResponseParams::DefaultResponseParam, &FocusTraceDelegate);
+	bFocusTracePending = true;
+}
+
+
+void AShooterCharacter::OnFocusTraceCompleted(const FTraceHandle& Handle, FTraceDatum& Data)
+{
+	bFocusTracePending = false;
+
+	const FHitResult* BlockingHit = Data.OutHits.FindByPredicate([](const FHitResult& Hit) { return Hit.bBlockingHit; });
+	SetFocusedUsable(BlockingHit ? Cast<AShooterUsableActor>(BlockingHit->GetActor()) : nullptr);
+}
+
+
+void AShooterCharacter::SetFocusedUsable(AShooterUsableActor* Usable)
+{
+	if (FocusedUsableActor == Usable)
+	{
+		return;
+	}
+
+	// End Focus
+	if (FocusedUsableActor)
+	{
+		FocusedUsableActor->OnEndFocus();
+	}
+
+	// Start Focus.
+	FocusedUsableActor = Usable;
+	if (Usable)
+	{
+		Usable->OnBeginFocus();
 	}
 }
 
@@ -871,6 +1092,22 @@ void AShooterCharacter::StopAllAnimMontages()
 }
 
 
+float AShooterCharacter::PlayAnimMontage(UAnimMontage* AnimMontage, float InPlayRate, FName StartSectionName)
+{
+	/* Our own notifies need the pose ticking on time, melee sweeps need the poses of whoever is in reach */
+	if (HasAuthority())
+	{
+		UShooterLagCompensationSubsystem* LagCompensation = GetWorld()->GetSubsystem<UShooterLagCompensationSubsystem>();
+		if (LagCompensation)
+		{
+			LagCompensation->NotifyCombatActivity(GetActorLocation(), GetActorLocation(), ServerAnimMeleeWakeRadius);
+		}
+	}
+
+	return Super::PlayAnimMontage(AnimMontage, InPlayRate, StartSectionName);
+}
+
+
 void AShooterCharacter::DeterminPlayerPose()
 {
 	if (CurrentWeapon == nullptr)
@@ -917,10 +1154,27 @@ void AShooterCharacter::Punch()
 		if (!UseMesh->GetAnimInstance()->Montage_IsPlaying(PunchAnim))
 		{
 			PlayAnimMontage(PunchAnim);
+
+			if (!HasAuthority())
+			{
+				ServerPunch();
+			}
 		}
 	}
 }
 
+
+void AShooterCharacter::ServerPunch_Implementation()
+{
+	Punch();
+}
+
+
+bool AShooterCharacter::ServerPunch_Validate()
+{
+	return true;
+}
+
 void AShooterCharacter::PawnClientRestart()
 {
 	Super::PawnClientRestart();
@@ -12,7 +12,7 @@
 AShooterExplosiveBarrel::AShooterExplosiveBarrel()
 {
 	HealthComp = CreateDefaultSubobject<UShooterHealthComponent>(TEXT("HealthComp"));
-	HealthComp->OnHealthChanged.AddDynamic(this, &AShooterExplosiveBarrel::OnHealthChanged);
+	HealthComp->OnHealthChangedNative.AddUObject(this, &AShooterExplosiveBarrel::OnHealthChanged);
 
 	MeshComp = CreateDefaultSubobject<UStaticMeshComponent>(TEXT("MeshComp"));
 	MeshComp->SetSimulatePhysics(true);
@@ -34,8 +34,7 @@ AShooterExplosiveBarrel::AShooterExplosiveBarrel()
 }
 
 
-void AShooterExplosiveBarrel::OnHealthChanged(UShooterHealthComponent* OwningHealthComp, float Health, float HealthDelta, const class UDamageType* DamageType,
-	class AController* InstigatedBy, AActor* DamageCauser)
+void AShooterExplosiveBarrel::OnHealthChanged(const FShooterHealthChange& Change)
 {
 	if (bExploded)
 	{
@@ -43,7 +42,7 @@ void AShooterExplosiveBarrel::OnHealthChanged(UShooterHealthComponent* OwningHea
 		return;
 	}
 
-	if (Health <= 0.0f)
+	if (Change.Health <= 0.0f)
 	{
 		// Explode!
 		bExploded = true;
@@ -63,10 +62,12 @@ void AShooterExplosiveBarrel::OnHealthChanged(UShooterHealthComponent* OwningHea
 
 void AShooterExplosiveBarrel::OnRep_Exploded()
 {
+#if !UE_SERVER
 	// Play FX and change self material to black
 	UGameplayStatics::SpawnEmitterAtLocation(GetWorld(), ExplosionEffect, GetActorLocation());
 	// Override material on mesh with blackened version
 	MeshComp->SetMaterial(0, ExplodedMaterial);
+#endif
 }
 
 
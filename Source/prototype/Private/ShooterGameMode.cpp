@@ -8,12 +8,18 @@
 #include "TimerManager.h"
 #include "ShooterCharacter.h"
 #include "ShooterWeapon.h"
+#include "Subsystems/ShooterPawnRecyclerSubsystem.h"
+#include "Kismet/GameplayStatics.h"
+#include "NavigationSystem.h"
 
 
 AShooterGameMode::AShooterGameMode()
 {
 	TimeBetweenWaves = 2.0f;
 
+	BotSpawnTag = "BotSpawn";
+	BotSpawnRadius = 300.0f;
+
 	GameStateClass = AShooterGameState::StaticClass();
 	PlayerStateClass = AShooterPlayerState::StaticClass();
 
@@ -166,10 +172,74 @@ void AShooterGameMode::SetPlayerDefaults(APawn* PlayerPawn)
 	SpawnDefaultInventory(PlayerPawn);
 }
 
+APawn* AShooterGameMode::SpawnDefaultPawnAtTransform_Implementation(AController* NewPlayer, const FTransform& SpawnTransform)
+{
+	UShooterPawnRecyclerSubsystem* Recycler = GetWorld()->GetSubsystem<UShooterPawnRecyclerSubsystem>();
+	if (Recycler)
+	{
+		APawn* ReusedPawn = Recycler->AcquirePawn(GetDefaultPawnClassForController(NewPlayer), SpawnTransform);
+		if (ReusedPawn)
+		{
+			return ReusedPawn;
+		}
+	}
+
+	return Super::SpawnDefaultPawnAtTransform_Implementation(NewPlayer, SpawnTransform);
+}
+
+APawn* AShooterGameMode::SpawnBot(TSubclassOf<APawn> BotClass, const FTransform& SpawnTransform)
+{
+	UShooterPawnRecyclerSubsystem* Recycler = GetWorld()->GetSubsystem<UShooterPawnRecyclerSubsystem>();
+	APawn* Bot = Recycler ? Recycler->AcquirePawn(BotClass, SpawnTransform) : nullptr;
+
+	if (Bot == nullptr)
+	{
+		FActorSpawnParameters SpawnInfo;
+		SpawnInfo.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AdjustIfPossibleButAlwaysSpawn;
+		return GetWorld()->SpawnActor<APawn>(BotClass, SpawnTransform, SpawnInfo);
+	}
+
+	/* Reused bots lost their AI controller when they died */
+	if (Bot->GetController() == nullptr && Bot->AutoPossessAI != EAutoPossessAI::Disabled)
+	{
+		Bot->SpawnDefaultController();
+	}
+
+	return Bot;
+}
+
+bool AShooterGameMode::SpawnWaveBot()
+{
+	if (WaveBotClass == nullptr || BotSpawnPoints.Num() == 0)
+	{
+		return false;
+	}
+
+	AActor* SpawnPoint = BotSpawnPoints[FMath::RandRange(0, BotSpawnPoints.Num() - 1)];
+	if (SpawnPoint == nullptr)
+	{
+		return false;
+	}
+
+	FVector SpawnLocation = SpawnPoint->GetActorLocation();
+
+	UNavigationSystemV1* NavSys = FNavigationSystem::GetCurrent<UNavigationSystemV1>(GetWorld());
+	FNavLocation NavLocation;
+	if (NavSys && BotSpawnRadius > 0.0f && NavSys->GetRandomReachablePointInRadius(SpawnLocation, BotSpawnRadius, NavLocation))
+	{
+		/* Navmesh points lie on the floor, lift the bot so its collision starts above it */
+		SpawnLocation = NavLocation.Location + FVector(0.0f, 0.0f, WaveBotClass->GetDefaultObject<APawn>()->GetDefaultHalfHeight());
+	}
+
+	return SpawnBot(WaveBotClass, FTransform(SpawnPoint->GetActorRotation(), SpawnLocation)) != nullptr;
+}
+
 void AShooterGameMode::StartPlay()
 {
 	Super::StartPlay();
 
+	UGameplayStatics::GetAllActorsWithTag(this, BotSpawnTag, BotSpawnPoints);
+
 	PrepareForNextWave();
 }
 
@@ -184,7 +254,10 @@ void AShooterGameMode::Tick(float DeltaSeconds)
 
 void AShooterGameMode::SpawnBotTimerElapsed()
 {
-	SpawnNewBot();
+	if (!SpawnWaveBot())
+	{
+		SpawnNewBot();
+	}
 
 	NrOfBotsToSpawn--;
 
@@ -2,14 +2,26 @@
 
 
 #include "ShooterKatanaWeapon.h"
+#include "Components/SkeletalMeshComponent.h"
+#include "Animation/AnimInstance.h"
 
 AShooterKatanaWeapon::AShooterKatanaWeapon()
 {
 	WeaponType = EWeaponType::Katana;
 
+	bUsesAmmo = false;
+
 }
 
-void AShooterKatanaWeapon::Fire()
+void AShooterKatanaWeapon::FireShot(const FVector& Origin, const FRotator& AimRotation, int32 ShotIndex, float Timestamp)
 {
+	/* The fire cadence is faster than a swing, let the current swing and its hit window finish like Punch does */
+	UAnimInstance* AnimInstance = MyPawn ? MyPawn->GetMesh()->GetAnimInstance() : nullptr;
+	if (AnimInstance && AnimInstance->Montage_IsPlaying(AttackAnim))
+	{
+		return;
+	}
 
+	/* Runs on the swinging client and on the server's simulated burst, the server's swing deals the damage */
+	PlayWeaponAnimation(AttackAnim);
 }
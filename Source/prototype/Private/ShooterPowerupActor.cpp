@@ -29,6 +29,8 @@ void AShooterPowerupActor::OnTickPowerup()
 		
 		OnExpired();
 
+		RemoveModifiers();
+
 		bIsPowerupActive = false;
 		OnRep_PowerupActive();
 
@@ -44,6 +46,16 @@ void AShooterPowerupActor::OnRep_PowerupActive()
 
 void AShooterPowerupActor::ActivatePowerup(AActor* ActiveFor)
 {
+	UShooterAttributeComponent* Attributes = ActiveFor ? ActiveFor->FindComponentByClass<UShooterAttributeComponent>() : nullptr;
+	if (Attributes && HasAuthority())
+	{
+		ModifiedAttributes = Attributes;
+		for (const FShooterAttributeModifier& Modifier : Modifiers)
+		{
+			ModifierHandles.Add(Attributes->AddModifier(Modifier.Attribute, Modifier.Op, Modifier.Magnitude));
+		}
+	}
+
 	OnActivated(ActiveFor);
 
 	bIsPowerupActive = true;
@@ -60,6 +72,31 @@ void AShooterPowerupActor::ActivatePowerup(AActor* ActiveFor)
 }
 
 
+void AShooterPowerupActor::RemoveModifiers()
+{
+	UShooterAttributeComponent* Attributes = ModifiedAttributes.Get();
+	if (Attributes)
+	{
+		for (int32 Handle : ModifierHandles)
+		{
+			Attributes->RemoveModifier(Handle);
+		}
+	}
+
+	ModifierHandles.Reset();
+	ModifiedAttributes.Reset();
+}
+
+
+void AShooterPowerupActor::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	/* Destroyed before expiring, don't leave the effect behind */
+	RemoveModifiers();
+
+	Super::EndPlay(EndPlayReason);
+}
+
+
 void AShooterPowerupActor::GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const
 {
 	Super::GetLifetimeReplicatedProps(OutLifetimeProps);
@@ -2,27 +2,95 @@
 
 
 #include "ShooterProjectileWeapon.h"
+#include "ShooterCharacter.h"
 
 AShooterProjectileWeapon::AShooterProjectileWeapon()
 {
 	StorageSlot = EInventorySlot::Secondary;
 	WeaponType = EWeaponType::Rifle;
+
+	MaxSpawnCatchUp = 0.3f;
+	ProjectileType = INDEX_NONE;
+	NextShotId = 0;
 }
 
-void AShooterProjectileWeapon::Fire()
+void AShooterProjectileWeapon::BeginPlay()
 {
-	AActor* MyOwner = GetOwner();
-	if (MyOwner) 
+	Super::BeginPlay();
+
+	UShooterProjectileSubsystem* Projectiles = GetProjectileSubsystem();
+	if (Projectiles)
 	{
-		FVector EyeLocation;
-		FRotator EyeRotation;
-		MyOwner->GetActorEyesViewPoint(EyeLocation, EyeRotation);
+		ProjectileType = Projectiles->RegisterProjectileType(GetClass(), ProjectileParams);
+	}
+}
 
-		FVector MuzzleLocation = MeshComp->GetSocketLocation(MuzzleSocketName);
-		
-		FActorSpawnParameters SpawnParams;
-		SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+UShooterProjectileSubsystem* AShooterProjectileWeapon::GetProjectileSubsystem() const
+{
+	return GetWorld()->GetSubsystem<UShooterProjectileSubsystem>();
+}
+
+void AShooterProjectileWeapon::FireShot(const FVector& Origin, const FRotator& AimRotation, int32 ShotIndex, float Timestamp)
+{
+	/* The server simulates the same burst the client fires and owns the damage, the firing client gets a cosmetic copy */
+	const bool bAuthoritative = HasAuthority();
+	if (!bAuthoritative && !(MyPawn && MyPawn->IsLocallyControlled()))
+	{
+		return;
+	}
+
+	UShooterProjectileSubsystem* Projectiles = GetProjectileSubsystem();
+	if (Projectiles == nullptr)
+	{
+		return;
+	}
+
+	/* Server and shooter fire the same shots in the same order, so their counts line up and the shooter's copy
+	   finds the server's detonation. Unlike the ammo sequence it also advances for host and AI shooters. */
+	FShooterProjectileSpawn Spawn;
+	Spawn.Origin = MeshComp->GetSocketLocation(MuzzleSocketName);
+	Spawn.Velocity = AimRotation.Vector() * ProjectileParams.Speed;
+	Spawn.Timestamp = Timestamp;
+	Spawn.ShotId = NextShotId++;
+
+	AController* InstigatorController = MyPawn ? MyPawn->GetController() : nullptr;
+	Projectiles->SpawnProjectile(ProjectileType, Spawn.Origin, Spawn.Velocity, 0.0f, this, Spawn.ShotId, InstigatorController, bAuthoritative);
+
+	if (bAuthoritative)
+	{
+		MulticastSpawnProjectile(Spawn);
 
-		GetWorld()->SpawnActor<AActor>(ProjectileClass, MuzzleLocation, EyeRotation, SpawnParams);
+		/* Projectiles sweep the current pose, wake everything along the flight path up front */
+		WakeTargetPoses(Spawn.Origin, Spawn.Origin + Spawn.Velocity * ProjectileParams.Lifetime);
+	}
+}
+
+void AShooterProjectileWeapon::MulticastSpawnProjectile_Implementation(const FShooterProjectileSpawn& Spawn)
+{
+	/* Server and shooter already run their own */
+	if (HasAuthority() || (MyPawn && MyPawn->IsLocallyControlled()))
+	{
+		return;
+	}
+
+	UShooterProjectileSubsystem* Projectiles = GetProjectileSubsystem();
+	if (Projectiles)
+	{
+		const float ElapsedTime = FMath::Clamp(GetServerWorldTime() - Spawn.Timestamp, 0.0f, MaxSpawnCatchUp);
+		Projectiles->SpawnProjectile(ProjectileType, Spawn.Origin, Spawn.Velocity, ElapsedTime, this, Spawn.ShotId, nullptr, false);
+	}
+}
+
+void AShooterProjectileWeapon::MulticastDetonateProjectile_Implementation(int32 ShotId, FVector_NetQuantize Location)
+{
+	if (HasAuthority())
+	{
+		return;
+	}
+
+	UShooterProjectileSubsystem* Projectiles = GetProjectileSubsystem();
+	if (Projectiles)
+	{
+		Projectiles->DetonateProjectile(ProjectileType, this, ShotId, Location);
 	}
 }
@@ -0,0 +1,216 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "ShooterShotgunWeapon.h"
+#include "Kismet/GameplayStatics.h"
+#include "Subsystems/ShooterHitScanSubsystem.h"
+#include "../prototype.h"
+
+AShooterShotgunWeapon::AShooterShotgunWeapon()
+{
+	WeaponType = EWeaponType::Rifle;
+
+	PelletCount = 10;
+	ImpactClusterRadius = 40.0f;
+
+	BaseDamage = 8.0f;
+	BulletSpread = 6.0f;
+	MaxAmmoPerClip = 8;
+}
+
+
+void AShooterShotgunWeapon::SamplePelletDirections(const FVector& AimDirection, int32 ShotIndex, TArrayView<FVector> OutDirections) const
+{
+	const float HalfRad = FMath::DegreesToRadians(BulletSpread);
+
+	FVector AxisY;
+	FVector AxisZ;
+	AimDirection.FindBestAxisVectors(AxisY, AxisZ);
+
+	const VectorRegister CosHalfMinusOne = VectorSetFloat1(FMath::Cos(HalfRad) - 1.0f);
+	const VectorRegister TwoPi = VectorSetFloat1(2.0f * PI);
+	const VectorRegister Epsilon = VectorSetFloat1(SMALL_NUMBER);
+
+	const int32 NumPellets = OutDirections.Num();
+	for (int32 First = 0; First < NumPellets; First += 4)
+	{
+		/* Same per-pellet uniforms as GetSpreadDirection, only the trigonometry runs four wide */
+		float U[4];
+		float V[4];
+		for (int32 Lane = 0; Lane < 4; Lane++)
+		{
+			GetSpreadUniforms(BurstSeed, ShotIndex, First + Lane, U[Lane], V[Lane]);
+		}
+
+		const VectorRegister CosTheta = VectorMultiplyAdd(MakeVectorRegister(U[0], U[1], U[2], U[3]), CosHalfMinusOne, VectorOne());
+		const VectorRegister SinThetaSq = VectorMax(VectorSubtract(VectorOne(), VectorMultiply(CosTheta, CosTheta)), Epsilon);
+		const VectorRegister SinTheta = VectorMultiply(SinThetaSq, VectorReciprocalSqrt(SinThetaSq));
+		const VectorRegister Phi = VectorMultiply(MakeVectorRegister(V[0], V[1], V[2], V[3]), TwoPi);
+
+		VectorRegister SinPhi;
+		VectorRegister CosPhi;
+		VectorSinCos(&SinPhi, &CosPhi, &Phi);
+
+		float CosThetas[4];
+		float SinThetas[4];
+		float SinPhis[4];
+		float CosPhis[4];
+		VectorStore(CosTheta, CosThetas);
+		VectorStore(SinTheta, SinThetas);
+		VectorStore(SinPhi, SinPhis);
+		VectorStore(CosPhi, CosPhis);
+
+		const int32 NumLanes = FMath::Min(4, NumPellets - First);
+		for (int32 Lane = 0; Lane < NumLanes; Lane++)
+		{
+			const FVector Radial = AxisY * CosPhis[Lane] + AxisZ * SinPhis[Lane];
+			OutDirections[First + Lane] = (AimDirection * CosThetas[Lane] + Radial * SinThetas[Lane]).GetSafeNormal();
+		}
+	}
+}
+
+
+void AShooterShotgunWeapon::FireShot(const FVector& Origin, const FRotator& AimRotation, int32 ShotIndex, float Timestamp)
+{
+	TArray<FVector, TInlineAllocator<16>> Directions;
+	Directions.SetNumUninitialized(PelletCount);
+	SamplePelletDirections(AimRotation.Vector(), ShotIndex, Directions);
+
+	const bool bLagCompensate = IsLagCompensated();
+
+	TArray<FShooterHitScanRequest, TInlineAllocator<16>> Requests;
+	Requests.SetNum(PelletCount);
+	for (int32 i = 0; i < PelletCount; i++)
+	{
+		FShooterHitScanRequest& Request = Requests[i];
+		Request.Weapon = this;
+		Request.TraceStart = Origin;
+		Request.TraceEnd = Origin + (Directions[i] * WeaponRange);
+		Request.ShotDirection = Directions[i];
+		Request.Timestamp = Timestamp;
+		Request.bTraceOcclusion = bLagCompensate;
+	}
+
+	/* All pellets come back in one OnHitScanGroupCompleted call */
+	QueueHitScanGroup(Requests);
+}
+
+
+void AShooterShotgunWeapon::OnHitScanGroupCompleted(TArrayView<const FShooterHitScanRequest> Requests, TArrayView<const FHitResult> Hits)
+{
+	AActor* MyOwner = GetOwner();
+	if (MyOwner == nullptr || Requests.Num() == 0)
+	{
+		return;
+	}
+
+	/* All pellets that hit the same actor, applied as one point damage */
+	struct FPelletVictim
+	{
+		AActor* Actor;
+		float Damage;
+		FHitResult FirstHit;
+		FVector ShotDirection;
+	};
+
+	/* Impacts on one surface type close together */
+	struct FImpactCluster
+	{
+		EPhysicalSurface SurfaceType;
+		FVector PointSum;
+		int32 Count;
+
+		FVector GetCenter() const
+		{
+			return PointSum / Count;
+		}
+	};
+
+	TArray<FPelletVictim, TInlineAllocator<16>> Victims;
+	TArray<FImpactCluster, TInlineAllocator<16>> Clusters;
+
+	const bool bLagCompensate = IsLagCompensated();
+	const float ClusterRadiusSq = FMath::Square(ImpactClusterRadius);
+
+	FVector TracerEndSum = FVector::ZeroVector;
+
+	for (int32 i = 0; i < Requests.Num(); i++)
+	{
+		const FShooterHitScanRequest& Request = Requests[i];
+		const FHitResult Hit = bLagCompensate ? ResolveLagCompensatedHit(Request, Hits[i]) : Hits[i];
+
+		if (!Hit.bBlockingHit)
+		{
+			TracerEndSum += Request.TraceEnd;
+			continue;
+		}
+
+		TracerEndSum += Hit.ImpactPoint;
+
+		const EPhysicalSurface SurfaceType = DetermineHitSurface(Hit);
+
+		AActor* HitActor = Hit.GetActor();
+		if (HasAuthority() && HitActor)
+		{
+			const float PelletBaseDamage = BaseDamage * GetDamageMultiplier();
+			const float PelletDamage = SurfaceType == SURFACE_FLESHVULNERABLE ? PelletBaseDamage * 4.0f : PelletBaseDamage;
+
+			FPelletVictim* Victim = Victims.FindByPredicate([HitActor](const FPelletVictim& Candidate) { return Candidate.Actor == HitActor; });
+			if (Victim)
+			{
+				Victim->Damage += PelletDamage;
+			}
+			else
+			{
+				Victims.Add({ HitActor, PelletDamage, Hit, Request.ShotDirection });
+			}
+		}
+
+		FImpactCluster* Cluster = Clusters.FindByPredicate([&](const FImpactCluster& Candidate)
+		{
+			return Candidate.SurfaceType == SurfaceType && FVector::DistSquared(Candidate.GetCenter(), Hit.ImpactPoint) <= ClusterRadiusSq;
+		});
+		if (Cluster)
+		{
+			Cluster->PointSum += Hit.ImpactPoint;
+			Cluster->Count++;
+		}
+		else
+		{
+			Clusters.Add({ SurfaceType, Hit.ImpactPoint, 1 });
+		}
+	}
+
+	for (const FPelletVictim& Victim : Victims)
+	{
+		UGameplayStatics::ApplyPointDamage(Victim.Actor, Victim.Damage, Victim.ShotDirection, Victim.FirstHit, MyOwner->GetInstigatorController(), MyOwner, DamageType);
+	}
+
+	/* One muzzle flash and tracer per shot, aimed at the middle of the pattern */
+	const FVector TracerEndPoint = TracerEndSum / Requests.Num();
+	PlayFireEffects(TracerEndPoint);
+
+	const FImpactCluster* LargestCluster = nullptr;
+	for (const FImpactCluster& Cluster : Clusters)
+	{
+		PlayImpactEffects(Cluster.SurfaceType, Cluster.GetCenter());
+
+		if (LargestCluster == nullptr || Cluster.Count > LargestCluster->Count)
+		{
+			LargestCluster = &Cluster;
+		}
+	}
+
+	/* Remote clients replay the shot as its tracer and its largest impact */
+	if (HasAuthority())
+	{
+		if (LargestCluster)
+		{
+			ShotHistory.AddShot(LargestCluster->GetCenter(), LargestCluster->SurfaceType, true);
+		}
+		else
+		{
+			ShotHistory.AddShot(TracerEndPoint, SurfaceType_Default, false);
+		}
+	}
+}
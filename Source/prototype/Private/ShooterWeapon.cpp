@@ -6,13 +6,30 @@
 #include "Kismet/GameplayStatics.h"
 #include "Particles/ParticleSystem.h"
 #include "Components/SkeletalMeshComponent.h"
+#include "Components/StaticMeshComponent.h"
 #include "Particles/ParticleSystemComponent.h"
 #include "PhysicalMaterials/PhysicalMaterial.h"
 #include "../prototype.h"
 #include "TimerManager.h"
 #include "Net/UnrealNetwork.h"
 #include "Sound/SoundCue.h"
-
+#include "Subsystems/ShooterHitScanSubsystem.h"
+#include "Components/ShooterHitboxHistoryComponent.h"
+#include "Subsystems/ShooterLagCompensationSubsystem.h"
+#include "GameFramework/GameStateBase.h"
+#include "Subsystems/ShooterFXPoolSubsystem.h"
+#include "Subsystems/ShooterAudioPoolSubsystem.h"
+#include "Components/AudioComponent.h"
+#include "Components/ShooterAttributeComponent.h"
+
+/* Bits over shots is the per-shot cost of the shot history on the wire */
+DECLARE_DWORD_COUNTER_STAT(TEXT("Shot History Bits Sent"), STAT_ShotHistoryBits, STATGROUP_Prototype);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Shot History Shots Sent"), STAT_ShotHistoryShots, STATGROUP_Prototype);
+
+#if UE_SERVER
+/* Nothing is drawn on a dedicated server, the debug branches compile away */
+static const int32 DebugWeaponDrawing = 0;
+#else
 static int32 DebugWeaponDrawing = 0;
 
 FAutoConsoleVariableRef CVARDebugWeaponDrawing(
@@ -20,6 +37,26 @@ FAutoConsoleVariableRef CVARDebugWeaponDrawing(
 	DebugWeaponDrawing,
 	TEXT("Draw Debug Lines for Weapons"),
 	ECVF_Cheat);
+#endif
+
+static float LagCompensationMaxRewind = 0.5f;
+
+FAutoConsoleVariableRef CVARLagCompensationMaxRewind(
+	TEXT("COOP.LagCompensation.MaxRewind"),
+	LagCompensationMaxRewind,
+	TEXT("Max time in seconds the server rewinds hitboxes to validate a client shot"),
+	ECVF_Default);
+
+static float ServerAnimShotWakeRadius = 300.0f;
+
+FAutoConsoleVariableRef CVARServerAnimShotWakeRadius(
+	TEXT("COOP.ServerAnim.ShotWakeRadius"),
+	ServerAnimShotWakeRadius,
+	TEXT("Characters within this distance of a shot evaluate their pose at full rate on a dedicated server"),
+	ECVF_Default);
+
+/* Aim updates a client may have buffered ahead of our cadence, a latency's worth of shots fits easily */
+static const int32 MaxBufferedBurstAims = 64;
 
 
 // Sets default values
@@ -28,16 +65,40 @@ AShooterWeapon::AShooterWeapon()
 	MeshComp = CreateDefaultSubobject<USkeletalMeshComponent>(TEXT("MeshComp"));
 	RootComponent = MeshComp;
 
+	HolsterMeshComp = CreateDefaultSubobject<UStaticMeshComponent>(TEXT("HolsterMeshComp"));
+	HolsterMeshComp->SetupAttachment(MeshComp);
+	HolsterMeshComp->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+	HolsterMeshComp->SetGenerateOverlapEvents(false);
+	HolsterMeshComp->CanCharacterStepUpOn = ECB_No;
+	HolsterMeshComp->SetHiddenInGame(true);
+
+	/* Ticks only while a burst is active, timers fire at most once per frame and would drop shots */
+	PrimaryActorTick.bCanEverTick = true;
+	PrimaryActorTick.bStartWithTickEnabled = false;
+
 	bIsEquipped = false;
 	CurrentState = EWeaponState::Idle;
 
+	bBurstActive = false;
+	bSimulatedBurst = false;
+	BurstShotCount = 0;
+	BurstSequence = 0;
+
+	AmmoSequence = 0;
+	ReloadSequence = INDEX_NONE;
+
+	ShotHistory.OwnerWeapon = this;
+
 	MuzzleSocketName = "MuzzleSocket";
 	TracerTargetName = "Target";
+	FXPrewarmCount = 4;
 
 	WeaponType = EWeaponType::Rifle;
 	StorageSlot = EInventorySlot::Primary;
 
 	BaseDamage = 20.0f;
+	WeaponRange = 10000.0f;
+	bUsesAmmo = true;
 	BulletSpread = 2.0f;
 
 	SetReplicates(true);
@@ -62,6 +123,9 @@ void AShooterWeapon::PostInitializeComponents()
 	TimeBetweenShots = 60.0f / ShotsPerMinute;
 	CurrentAmmo = FMath::Min(StartAmmo, MaxAmmo);
 	CurrentAmmoInClip = FMath::Min(MaxAmmoPerClip, StartAmmo);
+
+	AmmoState.Ammo = CurrentAmmo;
+	AmmoState.AmmoInClip = CurrentAmmoInClip;
 }
 
 
@@ -69,6 +133,17 @@ void AShooterWeapon::BeginPlay()
 {
 	Super::BeginPlay();
 
+#if !UE_SERVER
+	UShooterFXPoolSubsystem* FXPool = GetWorld()->GetSubsystem<UShooterFXPoolSubsystem>();
+	if (FXPool)
+	{
+		FXPool->Prewarm(MuzzleEffect, FXPrewarmCount);
+		FXPool->Prewarm(MuzzleFX, FXPrewarmCount);
+		FXPool->Prewarm(TracerEffect, FXPrewarmCount);
+		FXPool->Prewarm(DefaultImpactEffect, FXPrewarmCount);
+		FXPool->Prewarm(FleshImpactEffect, FXPrewarmCount);
+	}
+#endif
 }
 
 
@@ -100,6 +175,9 @@ void AShooterWeapon::SetOwningPawn(AShooterCharacter* NewOwner)
 {
 	if (MyPawn != NewOwner)
 	{
+		/* The old pawn no longer drives our aim */
+		SetTickPrerequisitePawn(nullptr);
+
 		SetInstigator(NewOwner);
 		MyPawn = NewOwner;
 		// Net owner for RPC calls.
@@ -108,6 +186,27 @@ void AShooterWeapon::SetOwningPawn(AShooterCharacter* NewOwner)
 }
 
 
+void AShooterWeapon::SetTickPrerequisitePawn(AShooterCharacter* NewPawn)
+{
+	if (TickPrerequisitePawn == NewPawn)
+	{
+		return;
+	}
+
+	if (TickPrerequisitePawn.IsValid())
+	{
+		RemoveTickPrerequisiteActor(TickPrerequisitePawn.Get());
+	}
+
+	TickPrerequisitePawn = NewPawn;
+
+	if (NewPawn)
+	{
+		AddTickPrerequisiteActor(NewPawn);
+	}
+}
+
+
 void AShooterWeapon::OnRep_MyPawn()
 {
 	if (MyPawn)
@@ -131,8 +230,9 @@ void AShooterWeapon::AttachMeshToPawn(EInventorySlot Slot)
 
 		USkeletalMeshComponent* PawnMesh = MyPawn->GetMesh();
 		FName AttachPoint = MyPawn->GetInventoryAttachPoint(Slot);
-		MeshComp->SetHiddenInGame(false);
 		MeshComp->AttachToComponent(PawnMesh, FAttachmentTransformRules::SnapToTargetNotIncludingScale, AttachPoint);
+
+		SetHolstered(Slot != EInventorySlot::Hands);
 	}
 }
 
@@ -141,6 +241,24 @@ void AShooterWeapon::DetachMeshFromPawn()
 {
 	MeshComp->DetachFromComponent(FDetachmentTransformRules::KeepWorldTransform);
 	MeshComp->SetHiddenInGame(true);
+	HolsterMeshComp->SetHiddenInGame(true);
+}
+
+
+void AShooterWeapon::SetHolstered(bool bHolstered)
+{
+	/* Without a proxy mesh the skeletal mesh stays visible, it still stops ticking */
+	const bool bShowProxy = bHolstered && HolsterMeshComp->GetStaticMesh() != nullptr;
+
+	MeshComp->SetHiddenInGame(bShowProxy);
+	MeshComp->SetComponentTickEnabled(!bHolstered);
+	HolsterMeshComp->SetHiddenInGame(!bShowProxy);
+
+	/* Only bursts tick the actor, a simulated one may still be waiting for the server to end it */
+	if (bHolstered && !bBurstActive)
+	{
+		SetActorTickEnabled(false);
+	}
 }
 
 
@@ -149,6 +267,9 @@ void AShooterWeapon::OnEquip(bool bPlayAnimation)
 	bPendingEquip = true;
 	DetermineWeaponState();
 
+	/* Aim after the pawn has updated its view for the frame */
+	SetTickPrerequisitePawn(MyPawn);
+
 	if (bPlayAnimation)
 	{
 		float Duration = PlayWeaponAnimation(EquipAnim);
@@ -179,6 +300,7 @@ void AShooterWeapon::OnUnEquip()
 {
 	bIsEquipped = false;
 	StopFire();
+	SetTickPrerequisitePawn(nullptr);
 
 	// switch to punch, play animation and sound
 	if (MyPawn && MyPawn->GetCurrentWeapon() == nullptr)
@@ -254,11 +376,55 @@ bool AShooterWeapon::IsAttachedToPawn() const // TODO: Review name to more accur
 
 void AShooterWeapon::StartFire()
 {
+	if (bBurstActive)
+	{
+		/* Close the previous burst first so both sides agree on its shot count */
+		StopFire();
+	}
+
 	SetWeaponState(EWeaponState::Firing);
 
-	float FirstDelay = FMath::Max(LastFireTime + TimeBetweenShots - GetWorld()->TimeSeconds, 0.0f);
+	UpdateTimeBetweenShots();
+
+	const float Now = GetWorld()->TimeSeconds;
+	float FirstDelay = FMath::Max(LastFireTime + TimeBetweenShots - Now, 0.0f);
+
+	/* Loop and muzzle for our own view, everyone else gets them from BurstCounter */
+	if (MyPawn && MyPawn->IsLocallyControlled())
+	{
+		SimulateWeaponFire();
+	}
+
+	if (HasAuthority())
+	{
+		BurstCounter++;
+	}
+
+	BurstSeed = FMath::Rand();
+	BurstStartTime = GetServerWorldTime() + FirstDelay;
+	BurstLocalStartTime = Now + FirstDelay;
+	BurstShotCount = 0;
+	BurstSequence = AmmoSequence + 1;
+	bHasBurstAim = false;
+	bBurstActive = true;
+
+	/* One reliable message per burst, the server fires the shots itself */
+	if (!HasAuthority())
+	{
+		ServerStartBurst(BurstStartTime, BurstSeed, BurstSequence);
+	}
+
+	AActor* MyOwner = GetOwner();
+	if (MyOwner)
+	{
+		MyOwner->GetActorEyesViewPoint(LastAimLocation, LastAimRotation);
+		LastAimTime = Now;
+	}
+
+	SetActorTickEnabled(true);
 
-	GetWorldTimerManager().SetTimer(TimerHandle_TimerBetweenShots, this, &AShooterWeapon::Fire, TimeBetweenShots, true, FirstDelay);
+	/* The first shot goes out this frame when it is already due */
+	FireOwedShots();
 }
 
 
@@ -266,92 +432,587 @@ void AShooterWeapon::StopFire()
 {
 	SetWeaponState(EWeaponState::Idle);
 
-	GetWorldTimerManager().ClearTimer(TimerHandle_TimerBetweenShots);
+	StopSimulatingWeaponFire();
+
+	if (bBurstActive)
+	{
+		if (HasAuthority())
+		{
+			EndSimulatedBurst();
+		}
+		else
+		{
+			ServerStopBurst(BurstShotCount);
+		}
+
+		bBurstActive = false;
+	}
+
+	SetActorTickEnabled(false);
 }
 
 
-void AShooterWeapon::Fire()
+void AShooterWeapon::Tick(float DeltaSeconds)
 {
-	//Trace the world, from pawn eyes to crosshair location
+	Super::Tick(DeltaSeconds);
 
-	if (!HasAuthority()) 
+	if (!bBurstActive)
+	{
+		SetActorTickEnabled(false);
+	}
+	else if (bSimulatedBurst)
+	{
+		SimulateBurstShots();
+	}
+	else
 	{
-		ServerFire();
+		FireOwedShots();
 	}
+}
+
 
+void AShooterWeapon::FireOwedShots()
+{
 	AActor* MyOwner = GetOwner();
-	if (MyOwner) 
+	if (MyOwner == nullptr)
 	{
-		FVector EyeLocation;
-		FRotator EyeRotation;
-		MyOwner->GetActorEyesViewPoint(EyeLocation, EyeRotation);
+		return;
+	}
 
-		FVector ShotDirection = EyeRotation.Vector();
+	//Trace the world, from pawn eyes to crosshair location
+	FVector EyeLocation;
+	FRotator EyeRotation;
+	MyOwner->GetActorEyesViewPoint(EyeLocation, EyeRotation);
 
-		// Bullet Spread
-		float HalfRad = FMath::DegreesToRadians(BulletSpread);
-		ShotDirection = FMath::VRandCone(ShotDirection, HalfRad, HalfRad);
+	const float Now = GetWorld()->TimeSeconds;
+	const float FrameSpan = Now - LastAimTime;
 
-		FVector TraceEnd = EyeLocation + (ShotDirection * 10000);
+	/* Every shot that came due since the last tick, however long the frame was */
+	while (bBurstActive)
+	{
+		const float ShotTime = BurstLocalStartTime + BurstShotCount * TimeBetweenShots;
+		if (ShotTime > Now)
+		{
+			break;
+		}
 
-		FCollisionQueryParams QueryParams;
-		QueryParams.AddIgnoredActor(MyOwner);
-		QueryParams.AddIgnoredActor(this);
-		QueryParams.bTraceComplex = true;
-		QueryParams.bReturnPhysicalMaterial = true;
+		if (bUsesAmmo && CurrentAmmoInClip <= 0)
+		{
+			HandleOutOfAmmo();
+			break;
+		}
 
-		//Particle "Target" parameter
-		FVector TracerEndPoint = TraceEnd;
+		/* Fire from where the view was at ShotTime, between last tick's view and this one */
+		const float Alpha = FrameSpan > KINDA_SMALL_NUMBER ? FMath::Clamp((ShotTime - LastAimTime) / FrameSpan, 0.0f, 1.0f) : 1.0f;
+		const FVector ShotOrigin = FMath::Lerp(LastAimLocation, EyeLocation, Alpha);
+		const FRotator ShotRotation = FQuat::Slerp(LastAimRotation.Quaternion(), EyeRotation.Quaternion(), Alpha).Rotator();
 
-		EPhysicalSurface SurfaceType = SurfaceType_Default;
+		const int32 ShotIndex = BurstShotCount++;
 
-		FHitResult Hit;
-		if (GetWorld()->LineTraceSingleByChannel(Hit, EyeLocation, TraceEnd, COLLISION_WEAPON, QueryParams)) 
+		if (HasAuthority())
 		{
-			//Blocking hit! Process damage
-			AActor* HitActor = Hit.GetActor();
-			
-			SurfaceType = UPhysicalMaterial::DetermineSurfaceType(Hit.PhysMaterial.Get());
-			
-			float ActualDamage = BaseDamage;
-			if (SurfaceType == SURFACE_FLESHVULNERABLE)
-			{
-				ActualDamage *= 4.0f;
-			}
+			ApplyAmmoChange(EShooterAmmoChange::Shot);
+			UpdateAmmoState();
+		}
+		else
+		{
+			/* Consume the round now instead of waiting a round trip for the server */
+			AmmoSequence = BurstSequence + ShotIndex;
+			PredictAmmoChange(EShooterAmmoChange::Shot, AmmoSequence);
 
-			UGameplayStatics::ApplyPointDamage(HitActor, ActualDamage, ShotDirection, Hit, MyOwner->GetInstigatorController(), MyOwner, DamageType);
+			SendBurstAim(ShotIndex, ShotRotation);
+		}
 
-			PlayImpactEffects(SurfaceType, Hit.ImpactPoint);
+		/* Shot times follow the cadence from the burst start, exactly like the server's simulation */
+		FireShot(ShotOrigin, ShotRotation, ShotIndex, BurstStartTime + ShotIndex * TimeBetweenShots);
 
-			TracerEndPoint = Hit.ImpactPoint;
+		LastFireTime = ShotTime;
+	}
 
-		}
+	LastAimLocation = EyeLocation;
+	LastAimRotation = EyeRotation;
+	LastAimTime = Now;
+}
 
-		if (DebugWeaponDrawing > 0) 
+
+void AShooterWeapon::FireShot(const FVector& Origin, const FRotator& AimRotation, int32 ShotIndex, float Timestamp)
+{
+	// Bullet Spread, identical on client and server for the same burst seed and shot index
+	const float HalfRad = FMath::DegreesToRadians(BulletSpread);
+	const FVector ShotDirection = GetSpreadDirection(AimRotation.Vector(), HalfRad, BurstSeed, ShotIndex);
+
+	FShooterHitScanRequest Request;
+	Request.Weapon = this;
+	Request.TraceStart = Origin;
+	Request.TraceEnd = Origin + (ShotDirection * WeaponRange);
+	Request.ShotDirection = ShotDirection;
+	Request.Timestamp = Timestamp;
+	Request.bTraceOcclusion = IsLagCompensated();
+
+	/* Traced asynchronously together with every other shot of this frame, see ProcessInstantHit */
+	QueueHitScan(Request);
+
+	if (DebugWeaponDrawing > 0) 
+	{
+		DrawDebugLine(GetWorld(), Request.TraceStart, Request.TraceEnd, FColor::White, false, 1.0f, 0, 1.0f);
+	}
+}
+
+
+/* Mix three counters into 32 well distributed bits (lowbias32 finalizer over a combined key) */
+static uint32 HashSpreadCounter(uint32 Seed, uint32 ShotIndex, uint32 SubIndex)
+{
+	uint32 Hash = Seed ^ (ShotIndex * 0x9E3779B9u) ^ (SubIndex * 0x85EBCA6Bu);
+	Hash ^= Hash >> 16;
+	Hash *= 0x7FEB352Du;
+	Hash ^= Hash >> 15;
+	Hash *= 0x846CA68Bu;
+	Hash ^= Hash >> 16;
+	return Hash;
+}
+
+
+void AShooterWeapon::GetSpreadUniforms(int32 Seed, int32 ShotIndex, int32 SubIndex, float& OutU, float& OutV)
+{
+	const uint32 Hash = HashSpreadCounter(static_cast<uint32>(Seed), static_cast<uint32>(ShotIndex), static_cast<uint32>(SubIndex));
+
+	/* 16 bits each for the two uniforms is plenty for a cone a few degrees wide */
+	OutU = (Hash & 0xFFFF) / 65535.0f;
+	OutV = (Hash >> 16) / 65535.0f;
+}
+
+
+FVector AShooterWeapon::GetSpreadDirection(const FVector& AimDirection, float HalfAngleRad, int32 Seed, int32 ShotIndex, int32 SubIndex)
+{
+	if (HalfAngleRad <= 0.0f)
+	{
+		return AimDirection;
+	}
+
+	float U;
+	float V;
+	GetSpreadUniforms(Seed, ShotIndex, SubIndex, U, V);
+
+	/* Uniform over the cone's solid angle, like VRandCone */
+	const float CosTheta = FMath::Lerp(1.0f, FMath::Cos(HalfAngleRad), U);
+	const float SinTheta = FMath::Sqrt(FMath::Max(0.0f, 1.0f - CosTheta * CosTheta));
+	const float Phi = V * 2.0f * PI;
+
+	FVector AxisY;
+	FVector AxisZ;
+	AimDirection.FindBestAxisVectors(AxisY, AxisZ);
+
+	return (AimDirection * CosTheta + (AxisY * FMath::Cos(Phi) + AxisZ * FMath::Sin(Phi)) * SinTheta).GetSafeNormal();
+}
+
+
+void AShooterWeapon::SendBurstAim(int32 ShotIndex, const FRotator& AimRotation)
+{
+	const uint16 AimPitch = FRotator::CompressAxisToShort(AimRotation.Pitch);
+	const uint16 AimYaw = FRotator::CompressAxisToShort(AimRotation.Yaw);
+
+	/* Holding still costs nothing, only changes in aim are sent */
+	if (!bHasBurstAim || AimPitch != BurstAimPitch || AimYaw != BurstAimYaw)
+	{
+		BurstAimPitch = AimPitch;
+		BurstAimYaw = AimYaw;
+		bHasBurstAim = true;
+
+		ServerUpdateBurstAim(static_cast<uint16>(ShotIndex), AimPitch, AimYaw);
+	}
+}
+
+
+void AShooterWeapon::ServerStartBurst_Implementation(float Timestamp, int32 Seed, int32 FirstSequence)
+{
+	if (bBurstActive)
+	{
+		EndSimulatedBurst();
+	}
+
+	const float Now = GetWorld()->GetTimeSeconds();
+
+	BurstSeed = Seed;
+	BurstSequence = FirstSequence;
+
+	UpdateTimeBetweenShots();
+
+	/* Shot timestamps can't reach further back than we can rewind */
+	BurstStartTime = FMath::Clamp(Timestamp, Now - LagCompensationMaxRewind, Now + TimeBetweenShots);
+
+	/* Run the cadence from when the burst reached us, so we don't get ahead of the client by its latency */
+	BurstSimStartTime = Now + FMath::Max(BurstStartTime - Now, 0.0f);
+
+	BurstShotCount = 0;
+	BurstAims.Reset();
+	bBurstActive = true;
+	bSimulatedBurst = true;
+
+	BurstCounter++;
+
+	/* A listen server never receives the counter, it plays remote bursts itself */
+	if (GetNetMode() != NM_DedicatedServer)
+	{
+		SimulateWeaponFire();
+	}
+
+	SetWeaponState(EWeaponState::Firing);
+
+	SimulateBurstShots();
+
+	SetActorTickEnabled(true);
+}
+
+
+bool AShooterWeapon::ServerStartBurst_Validate(float Timestamp, int32 Seed, int32 FirstSequence)
+{
+	return FMath::IsFinite(Timestamp);
+}
+
+
+void AShooterWeapon::ServerStopBurst_Implementation(int32 ShotCount)
+{
+	if (!bBurstActive)
+	{
+		return;
+	}
+
+	/* The client can't have fired more shots than the cadence allows since the burst reached us */
+	const float Elapsed = GetWorld()->GetTimeSeconds() - BurstSimStartTime;
+	const int32 MaxShots = Elapsed >= 0.0f ? FMath::FloorToInt(Elapsed / TimeBetweenShots) + 1 : 0;
+	const int32 FinalShotCount = FMath::Min(ShotCount, MaxShots);
+
+	while (BurstShotCount < FinalShotCount)
+	{
+		SimulateBurstShot(BurstShotCount++);
+	}
+
+	/* Acknowledge every shot the client predicted, including the ones we refused. A client can't have
+	   predicted more than the cadence allows plus what is left in the clip, so it can't push the ack ahead. */
+	const int32 AckShotCount = FMath::Min(ShotCount, MaxShots + (bUsesAmmo ? CurrentAmmoInClip : 0));
+	UpdateAmmoState(BurstSequence + AckShotCount - 1);
+
+	EndSimulatedBurst();
+}
+
+
+bool AShooterWeapon::ServerStopBurst_Validate(int32 ShotCount)
+{
+	return ShotCount >= 0;
+}
+
+
+void AShooterWeapon::ServerUpdateBurstAim_Implementation(uint16 ShotIndex, uint16 AimPitch, uint16 AimYaw)
+{
+	if (!bBurstActive || !bSimulatedBurst || BurstAims.Num() >= MaxBufferedBurstAims)
+	{
+		return;
+	}
+
+	/* Unreliable, an older update can arrive after a newer one and still applies to the shots up to the next */
+	int32 InsertIndex = BurstAims.Num();
+	while (InsertIndex > 0 && BurstAims[InsertIndex - 1].ShotIndex > ShotIndex)
+	{
+		InsertIndex--;
+	}
+
+	if (InsertIndex > 0 && BurstAims[InsertIndex - 1].ShotIndex == ShotIndex)
+	{
+		return;
+	}
+
+	FShooterBurstAim Aim;
+	Aim.ShotIndex = ShotIndex;
+	Aim.Pitch = AimPitch;
+	Aim.Yaw = AimYaw;
+	BurstAims.Insert(Aim, InsertIndex);
+
+	/* The shot this aim belongs to may have been held back waiting for it */
+	SimulateBurstShots();
+}
+
+
+bool AShooterWeapon::GetBurstAim(int32 ShotIndex, FRotator& OutAimRotation) const
+{
+	for (int32 i = BurstAims.Num() - 1; i >= 0; i--)
+	{
+		if (BurstAims[i].ShotIndex <= ShotIndex)
 		{
-			DrawDebugLine(GetWorld(), EyeLocation, TraceEnd, FColor::White, false, 1.0f, 0, 1.0f);
+			OutAimRotation.Pitch = FRotator::DecompressAxisFromShort(BurstAims[i].Pitch);
+			OutAimRotation.Yaw = FRotator::DecompressAxisFromShort(BurstAims[i].Yaw);
+			return true;
 		}
+	}
+
+	return false;
+}
+
+
+bool AShooterWeapon::ServerUpdateBurstAim_Validate(uint16 ShotIndex, uint16 AimPitch, uint16 AimYaw)
+{
+	return true;
+}
+
+
+void AShooterWeapon::SimulateBurstShots()
+{
+	if (!bBurstActive)
+	{
+		return;
+	}
+
+	/* Catch up on every shot owed since the last tick, several per tick on a slow server */
+	const float Elapsed = GetWorld()->GetTimeSeconds() - BurstSimStartTime;
+	const int32 ShotsOwed = Elapsed >= 0.0f ? FMath::FloorToInt(Elapsed / TimeBetweenShots) + 1 : 0;
+
+	/* The newest owed shot waits up to one interval for its aim, the ones before it have waited long enough.
+	   Aim is only sent when it changes, so an aim at or after a shot means nothing newer is coming for it. */
+	const int32 NewestAimShotIndex = BurstAims.Num() > 0 ? BurstAims.Last().ShotIndex : INDEX_NONE;
+	const int32 ShotsReady = NewestAimShotIndex >= ShotsOwed - 1 ? ShotsOwed : ShotsOwed - 1;
+
+	while (BurstShotCount < ShotsReady)
+	{
+		SimulateBurstShot(BurstShotCount++);
+	}
+
+	/* Only the newest aim at or before the next shot is still needed */
+	int32 NumStale = 0;
+	while (NumStale + 1 < BurstAims.Num() && BurstAims[NumStale + 1].ShotIndex <= BurstShotCount)
+	{
+		NumStale++;
+	}
+	BurstAims.RemoveAt(0, NumStale, false);
+}
 
-		PlayFireEffects(TracerEndPoint);
+
+void AShooterWeapon::SimulateBurstShot(int32 ShotIndex)
+{
+	AActor* MyOwner = GetOwner();
+	if (MyOwner == nullptr)
+	{
+		return;
+	}
+
+	FVector EyeLocation;
+	FRotator EyeRotation;
+	MyOwner->GetActorEyesViewPoint(EyeLocation, EyeRotation);
+
+	/* Prefer the aim the client reported for this shot, our own view of the shooter covers lost aim updates */
+	GetBurstAim(ShotIndex, EyeRotation);
+
+	/* An empty clip still acknowledges the shot, the client rolls back to our count */
+	if (!bUsesAmmo || CurrentAmmoInClip > 0)
+	{
+		ApplyAmmoChange(EShooterAmmoChange::Shot);
+
+		FireShot(EyeLocation, EyeRotation, ShotIndex, BurstStartTime + ShotIndex * TimeBetweenShots);
+
+		LastFireTime = BurstSimStartTime + ShotIndex * TimeBetweenShots;
+	}
+
+	UpdateAmmoState(BurstSequence + ShotIndex);
+}
+
+
+void AShooterWeapon::EndSimulatedBurst()
+{
+	bBurstActive = false;
+	bSimulatedBurst = false;
+
+	BurstCounter = 0;
+	StopSimulatingWeaponFire();
+
+	SetActorTickEnabled(false);
+
+	SetWeaponState(EWeaponState::Idle);
+}
+
+
+void AShooterWeapon::QueueHitScan(const FShooterHitScanRequest& Request)
+{
+	UShooterHitScanSubsystem* HitScan = GetWorld()->GetSubsystem<UShooterHitScanSubsystem>();
+	if (HitScan)
+	{
+		HitScan->QueueTrace(Request);
+	}
+
+	WakeTargetPoses(Request.TraceStart, Request.TraceEnd);
+}
+
+
+void AShooterWeapon::QueueHitScanGroup(TArrayView<const FShooterHitScanRequest> Requests)
+{
+	UShooterHitScanSubsystem* HitScan = GetWorld()->GetSubsystem<UShooterHitScanSubsystem>();
+	if (HitScan)
+	{
+		HitScan->QueueTraceGroup(Requests);
+	}
+
+	for (const FShooterHitScanRequest& Request : Requests)
+	{
+		WakeTargetPoses(Request.TraceStart, Request.TraceEnd);
+	}
+}
+
+
+void AShooterWeapon::WakeTargetPoses(const FVector& Start, const FVector& End) const
+{
+	if (!HasAuthority())
+	{
+		return;
+	}
+
+	UShooterLagCompensationSubsystem* LagCompensation = GetWorld()->GetSubsystem<UShooterLagCompensationSubsystem>();
+	if (LagCompensation)
+	{
+		LagCompensation->NotifyCombatActivity(Start, End, ServerAnimShotWakeRadius);
+	}
+}
+
+
+float AShooterWeapon::GetServerWorldTime() const
+{
+	AGameStateBase* GS = GetWorld()->GetGameState();
+	return GS ? GS->GetServerWorldTimeSeconds() : GetWorld()->GetTimeSeconds();
+}
+
+
+float AShooterWeapon::GetDamageMultiplier() const
+{
+	const UShooterAttributeComponent* Attributes = MyPawn ? MyPawn->GetAttributeComp() : nullptr;
+	return Attributes ? Attributes->GetValue(EShooterAttribute::Damage) : 1.0f;
+}
+
+
+void AShooterWeapon::UpdateTimeBetweenShots()
+{
+	/* The owning client and the server both have the owner's modifiers, so they agree on the cadence */
+	const UShooterAttributeComponent* Attributes = MyPawn ? MyPawn->GetAttributeComp() : nullptr;
+	const float FireRate = Attributes ? Attributes->GetValue(EShooterAttribute::FireRate) : 1.0f;
+
+	TimeBetweenShots = 60.0f / FMath::Max(ShotsPerMinute * FireRate, KINDA_SMALL_NUMBER);
+}
+
+
+void AShooterWeapon::OnHitScanTraceCompleted(const FShooterHitScanRequest& Request, const FHitResult& Hit)
+{
+	ProcessInstantHit(Request, Hit);
+}
+
+
+void AShooterWeapon::OnHitScanGroupCompleted(TArrayView<const FShooterHitScanRequest> Requests, TArrayView<const FHitResult> Hits)
+{
+	for (int32 i = 0; i < Requests.Num(); i++)
+	{
+		ProcessInstantHit(Requests[i], Hits[i]);
+	}
+}
+
+
+void AShooterWeapon::ProcessInstantHit(const FShooterHitScanRequest& Request, const FHitResult& WorldHit)
+{
+	AActor* MyOwner = GetOwner();
+	if (MyOwner == nullptr)
+	{
+		/* Weapon was dropped while the trace was in flight */
+		return;
+	}
+
+	/* Remote shooters saw their targets in the past, judge the shot against that */
+	FHitResult Hit = WorldHit;
+	if (IsLagCompensated())
+	{
+		Hit = ResolveLagCompensatedHit(Request, WorldHit);
+	}
+
+	//Particle "Target" parameter
+	FVector TracerEndPoint = Request.TraceEnd;
+
+	EPhysicalSurface SurfaceType = SurfaceType_Default;
+
+	if (Hit.bBlockingHit) 
+	{
+		//Blocking hit! Process damage
+		AActor* HitActor = Hit.GetActor();
+
+		SurfaceType = DetermineHitSurface(Hit);
 
 		if (HasAuthority())
 		{
-			HitScanTrace.TraceTo = TracerEndPoint;
-			HitScanTrace.SurfaceType = SurfaceType;			
+			float ActualDamage = BaseDamage * GetDamageMultiplier();
+			if (SurfaceType == SURFACE_FLESHVULNERABLE)
+			{
+				ActualDamage *= 4.0f;
+			}
+
+			UGameplayStatics::ApplyPointDamage(HitActor, ActualDamage, Request.ShotDirection, Hit, MyOwner->GetInstigatorController(), MyOwner, DamageType);
 		}
 
-		LastFireTime = GetWorld()->TimeSeconds;
+		PlayImpactEffects(SurfaceType, Hit.ImpactPoint);
+
+		TracerEndPoint = Hit.ImpactPoint;
+	}
+
+	PlayFireEffects(TracerEndPoint);
+
+	if (HasAuthority())
+	{
+		ShotHistory.AddShot(TracerEndPoint, SurfaceType, Hit.bBlockingHit);
 	}
 }
 
-void AShooterWeapon::ServerFire_Implementation()
+
+bool AShooterWeapon::IsLagCompensated() const
 {
-	Fire();
+	return HasAuthority() && MyPawn && !MyPawn->IsLocallyControlled();
 }
 
-bool AShooterWeapon::ServerFire_Validate()
+
+FHitResult AShooterWeapon::ResolveLagCompensatedHit(const FShooterHitScanRequest& Request, const FHitResult& WorldHit) const
 {
-	return true;
+	UShooterLagCompensationSubsystem* LagCompensation = GetWorld()->GetSubsystem<UShooterLagCompensationSubsystem>();
+	if (LagCompensation == nullptr)
+	{
+		return WorldHit;
+	}
+
+	/* Targets with a history are judged by their rewound pose only, their current pose doesn't stop the shot */
+	AActor* WorldHitActor = WorldHit.GetActor();
+	const bool bWorldHitRewindable = WorldHitActor && WorldHitActor->FindComponentByClass<UShooterHitboxHistoryComponent>();
+
+	/* The world behind a current pose still stops the rewound shot, the occlusion trace left every pawn out */
+	const FHitResult& BlockingHit = (bWorldHitRewindable && Request.bTraceOcclusion) ? Request.OcclusionHit : WorldHit;
+
+	const FVector RewindTraceEnd = BlockingHit.bBlockingHit ? BlockingHit.ImpactPoint : Request.TraceEnd;
+
+	const float Now = GetWorld()->GetTimeSeconds();
+	const float RewindTime = FMath::Clamp(Request.Timestamp, Now - LagCompensationMaxRewind, Now);
+
+	FShooterRewindHit RewindHit;
+	UShooterHitboxHistoryComponent* History = nullptr;
+	if (LagCompensation->RewindRayTest(RewindTime, Request.TraceStart, RewindTraceEnd, GetOwner(), RewindHit, History))
+	{
+		return History->MakeHitResult(RewindHit, Request.TraceStart, Request.TraceEnd);
+	}
+
+	return BlockingHit;
+}
+
+
+EPhysicalSurface AShooterWeapon::DetermineHitSurface(const FHitResult& Hit) const
+{
+	AActor* HitActor = Hit.GetActor();
+	UShooterHitboxHistoryComponent* History = HitActor ? HitActor->FindComponentByClass<UShooterHitboxHistoryComponent>() : nullptr;
+	if (History)
+	{
+		const EPhysicalSurface HitboxSurface = History->GetSurfaceForBone(Hit.BoneName);
+		if (HitboxSurface != SurfaceType_Default)
+		{
+			return HitboxSurface;
+		}
+	}
+
+	return UPhysicalMaterial::DetermineSurfaceType(Hit.PhysMaterial.Get());
 }
 
 
@@ -364,20 +1025,180 @@ bool AShooterWeapon::CanFire() const
 }
 
 
-void AShooterWeapon::OnRep_HitScanTrace()
+void AShooterWeapon::PlayReplicatedShot(const FShooterShotRecord& Shot)
+{
+	PlayFireEffects(Shot.TraceTo);
+
+	if (Shot.bBlockingHit)
+	{
+		PlayImpactEffects(Shot.SurfaceType, Shot.TraceTo);
+	}
+}
+
+
+/* Base state of one connection: the shot counter it has been sent up to */
+struct FShooterShotHistoryState : public INetDeltaBaseState
+{
+	explicit FShooterShotHistoryState(uint8 InShotCounter)
+		: ShotCounter(InShotCounter)
+	{
+	}
+
+	virtual bool IsStateEqual(INetDeltaBaseState* OtherState) override
+	{
+		return ShotCounter == static_cast<FShooterShotHistoryState*>(OtherState)->ShotCounter;
+	}
+
+	uint8 ShotCounter;
+};
+
+
+void FShooterShotHistory::AddShot(const FVector& TraceTo, EPhysicalSurface SurfaceType, bool bBlockingHit)
+{
+	if (Shots.Num() < Capacity)
+	{
+		Shots.AddDefaulted();
+	}
+
+	/* Recycle the oldest slot */
+	FShooterShotRecord& Shot = Shots[NextSlot];
+	Shot.TraceTo = FVector(FMath::RoundToFloat(TraceTo.X), FMath::RoundToFloat(TraceTo.Y), FMath::RoundToFloat(TraceTo.Z));
+	Shot.SurfaceType = SurfaceType;
+	Shot.bBlockingHit = bBlockingHit;
+	Shot.ShotCounter = NextShotCounter++;
+
+	NextSlot = (NextSlot + 1) % Capacity;
+}
+
+
+bool FShooterShotHistory::NetDeltaSerialize(FNetDeltaSerializeInfo& DeltaParms)
 {
-	PlayFireEffects(HitScanTrace.TraceTo);
+	if (DeltaParms.Writer)
+	{
+		FBitWriter& Writer = *DeltaParms.Writer;
+		const FShooterShotHistoryState* OldState = static_cast<FShooterShotHistoryState*>(DeltaParms.OldState);
+
+		/* Delta against the acknowledged counter, a connection that fell more than a ring behind gets the whole ring */
+		const int32 NumUnsent = OldState ? static_cast<uint8>(NextShotCounter - OldState->ShotCounter) : Shots.Num();
+		const int32 NumNew = FMath::Min(NumUnsent, Shots.Num());
+		if (OldState && NumNew == 0)
+		{
+			return false;
+		}
+
+		*DeltaParms.NewState = MakeShared<FShooterShotHistoryState>(NextShotCounter);
+
+		const int64 StartBits = Writer.GetNumBits();
+
+		uint8 NewestCounter = NextShotCounter - 1;
+		Writer << NewestCounter;
+
+		uint32 NumNewValue = NumNew;
+		Writer.SerializeInt(NumNewValue, Capacity + 1);
+
+		/* Consecutive shots land close together, so the endpoint deltas pack into a few bits per axis */
+		FVector PreviousTraceTo = FVector::ZeroVector;
+		for (int32 i = 0; i < NumNew; i++)
+		{
+			const FShooterShotRecord& Shot = Shots[(NextSlot - NumNew + i + Capacity) % Capacity];
+
+			/* Hit flag and surface (6 bits, SurfaceType62 is the last one) */
+			uint8 HitAndSurface = static_cast<uint8>((Shot.bBlockingHit ? 0x40 : 0) | (Shot.SurfaceType & 0x3F));
+			Writer.SerializeBits(&HitAndSurface, 7);
+
+			FVector_NetQuantize Delta = Shot.TraceTo - PreviousTraceTo;
+			bool bSuccess = true;
+			Delta.NetSerialize(Writer, DeltaParms.Map, bSuccess);
+
+			PreviousTraceTo = Shot.TraceTo;
+		}
+
+		INC_DWORD_STAT_BY(STAT_ShotHistoryBits, Writer.GetNumBits() - StartBits);
+		INC_DWORD_STAT_BY(STAT_ShotHistoryShots, NumNew);
+
+		return true;
+	}
+
+	if (DeltaParms.Reader)
+	{
+		FBitReader& Reader = *DeltaParms.Reader;
+
+		uint8 NewestCounter = 0;
+		Reader << NewestCounter;
+
+		uint32 NumNew = 0;
+		Reader.SerializeInt(NumNew, Capacity + 1);
 
-	PlayImpactEffects(HitScanTrace.SurfaceType, HitScanTrace.TraceTo);
+		TArray<FShooterShotRecord, TInlineAllocator<Capacity>> NewShots;
+		NewShots.SetNum(NumNew);
+
+		FVector PreviousTraceTo = FVector::ZeroVector;
+		for (uint32 i = 0; i < NumNew; i++)
+		{
+			FShooterShotRecord& Shot = NewShots[i];
+
+			uint8 HitAndSurface = 0;
+			Reader.SerializeBits(&HitAndSurface, 7);
+			Shot.bBlockingHit = (HitAndSurface & 0x40) != 0;
+			Shot.SurfaceType = static_cast<EPhysicalSurface>(HitAndSurface & 0x3F);
+
+			FVector_NetQuantize Delta;
+			bool bSuccess = true;
+			Delta.NetSerialize(Reader, DeltaParms.Map, bSuccess);
+
+			Shot.TraceTo = PreviousTraceTo + Delta;
+			Shot.ShotCounter = static_cast<uint8>(NewestCounter - NumNew + 1 + i);
+
+			PreviousTraceTo = Shot.TraceTo;
+		}
+
+		if (Reader.IsError())
+		{
+			return false;
+		}
+
+		PlayNewShots(NewShots);
+		return true;
+	}
+
+	return false;
+}
+
+
+void FShooterShotHistory::PlayNewShots(TArrayView<const FShooterShotRecord> NewShots)
+{
+	/* History that came with the weapon's initial replication is old news */
+	const bool bCanPlay = OwnerWeapon && OwnerWeapon->HasActorBegunPlay();
+
+	for (const FShooterShotRecord& Shot : NewShots)
+	{
+		/* A resend after a lost packet can repeat shots we already played */
+		const uint8 Age = static_cast<uint8>(Shot.ShotCounter - LastPlayedShotCounter);
+		if (bHasPlayedShot && (Age == 0 || Age > 128))
+		{
+			continue;
+		}
+
+		if (bCanPlay)
+		{
+			OwnerWeapon->PlayReplicatedShot(Shot);
+		}
+
+		LastPlayedShotCounter = Shot.ShotCounter;
+		bHasPlayedShot = true;
+	}
 }
 
 
 void AShooterWeapon::SimulateWeaponFire()
 {
-	if (MuzzleFX)
+#if !UE_SERVER
+	UShooterFXPoolSubsystem* FXPool = GetWorld()->GetSubsystem<UShooterFXPoolSubsystem>();
+	if (MuzzleFX && FXPool)
 	{
-		MuzzlePSC = UGameplayStatics::SpawnEmitterAttached(MuzzleFX, MeshComp, MuzzleAttachPoint);
+		MuzzlePSC = FXPool->SpawnAttached(MuzzleFX, MeshComp, MuzzleAttachPoint);
 	}
+#endif
 
 	if (!bPlayingFireAnim)
 	{
@@ -385,7 +1206,11 @@ void AShooterWeapon::SimulateWeaponFire()
 		bPlayingFireAnim = true;
 	}
 
-	PlayWeaponSound(FireSound);
+	/* One held voice per burst instead of a sound per shot */
+	if (FireLoopSound && FireLoopAC == nullptr)
+	{
+		FireLoopAC = PlayWeaponSound(FireLoopSound, true);
+	}
 }
 
 
@@ -396,6 +1221,15 @@ void AShooterWeapon::StopSimulatingWeaponFire()
 		StopWeaponAnimation(FireAnim);
 		bPlayingFireAnim = false;
 	}
+
+	if (FireLoopAC)
+	{
+		/* The component goes back to the pool once the fade finishes */
+		FireLoopAC->FadeOut(0.1f, 0.0f);
+		FireLoopAC = nullptr;
+
+		PlayWeaponSound(FireFinishSound);
+	}
 }
 
 
@@ -425,13 +1259,16 @@ FVector AShooterWeapon::GetMuzzleDirection() const
 }
 
 
-UAudioComponent* AShooterWeapon::PlayWeaponSound(USoundCue* SoundToPlay)
+UAudioComponent* AShooterWeapon::PlayWeaponSound(USoundCue* SoundToPlay, bool bLooping)
 {
 	UAudioComponent* AC = nullptr;
-	if (SoundToPlay && MyPawn)
+#if !UE_SERVER
+	UShooterAudioPoolSubsystem* AudioPool = GetWorld()->GetSubsystem<UShooterAudioPoolSubsystem>();
+	if (SoundToPlay && MyPawn && AudioPool)
 	{
-		AC = UGameplayStatics::SpawnSoundAttached(SoundToPlay, MyPawn->GetRootComponent());
+		AC = AudioPool->PlayAttached(SoundToPlay, MyPawn->GetRootComponent(), this, bLooping);
 	}
+#endif
 
 	return AC;
 }
@@ -582,6 +1419,8 @@ int32 AShooterWeapon::GiveAmmo(int32 AddAmount)
 		ClientStartReload();
 	}
 
+	UpdateAmmoState();
+
 	/* Return the unused ammo when weapon is filled up */
 	return FMath::Max(0, AddAmount - MissingAmmo);
 }
@@ -591,6 +1430,8 @@ void AShooterWeapon::SetAmmoCount(int32 NewTotalAmount)
 {
 	CurrentAmmo = FMath::Min(MaxAmmo, NewTotalAmount);
 	CurrentAmmoInClip = FMath::Min(MaxAmmoPerClip, CurrentAmmo);
+
+	UpdateAmmoState();
 }
 
 
@@ -623,7 +1464,14 @@ void AShooterWeapon::StartReload(bool bFromReplication)
 	/* Push the request to server */
 	if (!bFromReplication && !HasAuthority())
 	{
-		ServerStartReload();
+		/* Reloading ends the burst, so its shots are numbered before the reload */
+		if (bBurstActive)
+		{
+			StopFire();
+		}
+
+		ReloadSequence = ++AmmoSequence;
+		ServerStartReload(ReloadSequence);
 	}
 
 	/* If local execute requested or we are running on the server */
@@ -639,7 +1487,8 @@ void AShooterWeapon::StartReload(bool bFromReplication)
 		}
 
 		GetWorldTimerManager().SetTimer(TimerHandle_StopReload, this, &AShooterWeapon::StopSimulateReload, AnimDuration, false);
-		if (HasAuthority())
+		/* The owning client fills its clip on its own timer as a prediction */
+		if (HasAuthority() || (MyPawn && MyPawn->IsLocallyControlled()))
 		{
 			GetWorldTimerManager().SetTimer(TimerHandle_ReloadWeapon, this, &AShooterWeapon::ReloadWeapon, FMath::Max(0.1f, AnimDuration - 0.1f), false);
 		}
@@ -665,11 +1514,90 @@ void AShooterWeapon::StopSimulateReload()
 
 void AShooterWeapon::ReloadWeapon()
 {
-	int32 ClipDelta = FMath::Min(MaxAmmoPerClip - CurrentAmmoInClip, CurrentAmmo - CurrentAmmoInClip);
+	if (HasAuthority())
+	{
+		ApplyAmmoChange(EShooterAmmoChange::Reload);
+		UpdateAmmoState(ReloadSequence);
+	}
+	else if (ReloadSequence > AmmoState.AckedSequence)
+	{
+		/* Skipped when the server's fill already arrived */
+		PredictAmmoChange(EShooterAmmoChange::Reload, ReloadSequence);
+	}
+}
+
+
+void AShooterWeapon::ApplyAmmoChange(EShooterAmmoChange Type)
+{
+	switch (Type)
+	{
+	case EShooterAmmoChange::Shot:
+		if (bUsesAmmo && CurrentAmmoInClip > 0)
+		{
+			UseAmmo();
+		}
+		break;
+	case EShooterAmmoChange::Reload:
+		{
+			int32 ClipDelta = FMath::Min(MaxAmmoPerClip - CurrentAmmoInClip, CurrentAmmo - CurrentAmmoInClip);
+
+			if (ClipDelta > 0)
+			{
+				CurrentAmmoInClip += ClipDelta;
+			}
+		}
+		break;
+	}
+}
+
+
+void AShooterWeapon::PredictAmmoChange(EShooterAmmoChange Type, int32 Sequence)
+{
+	ApplyAmmoChange(Type);
+
+	FShooterPendingAmmoChange Change;
+	Change.Sequence = Sequence;
+	Change.Type = Type;
+	PendingAmmoChanges.Add(Change);
+}
+
+
+void AShooterWeapon::UpdateAmmoState(int32 AckedSequence)
+{
+	AmmoState.Ammo = CurrentAmmo;
+	AmmoState.AmmoInClip = CurrentAmmoInClip;
+	AmmoState.AckedSequence = FMath::Max(AmmoState.AckedSequence, AckedSequence);
+}
+
+
+void AShooterWeapon::OnRep_AmmoState()
+{
+	const int32 AckedSequence = AmmoState.AckedSequence;
+	PendingAmmoChanges.RemoveAll([AckedSequence](const FShooterPendingAmmoChange& Change)
+	{
+		return Change.Sequence <= AckedSequence;
+	});
+
+	/* Replaying on top of the server's state lands on the predicted counts whenever the server agreed */
+	CurrentAmmo = AmmoState.Ammo;
+	CurrentAmmoInClip = AmmoState.AmmoInClip;
 
-	if (ClipDelta > 0)
+	for (const FShooterPendingAmmoChange& Change : PendingAmmoChanges)
 	{
-		CurrentAmmoInClip += ClipDelta;
+		ApplyAmmoChange(Change.Type);
+	}
+}
+
+
+void AShooterWeapon::HandleOutOfAmmo()
+{
+	StopFire();
+
+	PlayWeaponSound(OutOfAmmoSound);
+
+	if (MyPawn && MyPawn->IsLocallyControlled() && CanReload())
+	{
+		StartReload();
 	}
 }
 
@@ -697,13 +1625,23 @@ void AShooterWeapon::OnRep_Reload()
 }
 
 
-void AShooterWeapon::ServerStartReload_Implementation()
+void AShooterWeapon::ServerStartReload_Implementation(int32 Sequence)
 {
-	StartReload();
+	ReloadSequence = Sequence;
+
+	if (CanReload())
+	{
+		StartReload();
+	}
+	else
+	{
+		/* Refused, let the client drop its prediction */
+		UpdateAmmoState(Sequence);
+	}
 }
 
 
-bool AShooterWeapon::ServerStartReload_Validate()
+bool AShooterWeapon::ServerStartReload_Validate(int32 Sequence)
 {
 	return true;
 }
@@ -729,38 +1667,50 @@ void AShooterWeapon::ClientStartReload_Implementation()
 
 void AShooterWeapon::PlayFireEffects(FVector TraceEnd)
 {
-	if (MuzzleEffect) 
+#if !UE_SERVER
+	/* Far away shooters skip tracers, dormant ones skip all fire effects */
+	const EShooterSignificance Significance = MyPawn ? MyPawn->GetSignificance() : EShooterSignificance::High;
+	if (Significance == EShooterSignificance::Dormant)
 	{
-		UGameplayStatics::SpawnEmitterAttached(MuzzleEffect, MeshComp, MuzzleSocketName);
+		return;
 	}
 
-	if (TracerEffect) 
+	if (FireLoopSound == nullptr)
 	{
+		PlayWeaponSound(FireSound);
+	}
 
-		FVector MuzzleLocation = MeshComp->GetSocketLocation(MuzzleSocketName);
-
-		UParticleSystemComponent* TracerComp = UGameplayStatics::SpawnEmitterAtLocation(GetWorld(), TracerEffect, MuzzleLocation);
+	/* Effects come from the world's pool, no components are created per shot */
+	UShooterFXPoolSubsystem* FXPool = GetWorld()->GetSubsystem<UShooterFXPoolSubsystem>();
+	if (FXPool)
+	{
+		FXPool->SpawnAttached(MuzzleEffect, MeshComp, MuzzleSocketName);
 
-		if (TracerComp) {
+		if (TracerEffect && Significance < EShooterSignificance::Low)
+		{
+			FVector MuzzleLocation = MeshComp->GetSocketLocation(MuzzleSocketName);
 
-			TracerComp->SetVectorParameter(TracerTargetName, TraceEnd);
+			FXPool->SpawnBeam(TracerEffect, MuzzleLocation, TraceEnd, TracerTargetName);
 		}
 	}
 
 	APawn* MyOwner = Cast<APawn>(GetOwner());
 	if (MyOwner)
 	{
+		/* Shooters play their own fire effects, a server never sends the shake over the network */
 		APlayerController* PC = Cast<APlayerController>(MyOwner->GetController());
-		if (PC)
+		if (PC && PC->IsLocalController())
 		{
 			PC->ClientPlayCameraShake(FireCamShake);
 		}
 	}
+#endif
 }
 
 
 void AShooterWeapon::PlayImpactEffects(EPhysicalSurface SurfaceType, FVector ImpactPoint)
 {
+#if !UE_SERVER
 	UParticleSystem* SelectedEffect = nullptr;
 	switch (SurfaceType)
 	{
@@ -773,27 +1723,28 @@ void AShooterWeapon::PlayImpactEffects(EPhysicalSurface SurfaceType, FVector Imp
 		break;
 	}
 
-	if (SelectedEffect)
+	UShooterFXPoolSubsystem* FXPool = GetWorld()->GetSubsystem<UShooterFXPoolSubsystem>();
+	if (SelectedEffect && FXPool)
 	{
 		FVector MuzzleLocation = MeshComp->GetSocketLocation(MuzzleSocketName);
 
 		FVector ShotDirection = ImpactPoint - MuzzleLocation;
 		ShotDirection.Normalize();
 
-		UGameplayStatics::SpawnEmitterAtLocation(GetWorld(), SelectedEffect, ImpactPoint, ShotDirection.Rotation());
+		FXPool->SpawnAtLocation(SelectedEffect, ImpactPoint, ShotDirection.Rotation());
 	}
+#endif
 }
 
 void AShooterWeapon::GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const
 {
 	Super::GetLifetimeReplicatedProps(OutLifetimeProps);
 
-	DOREPLIFETIME_CONDITION(AShooterWeapon, HitScanTrace, COND_SkipOwner);
+	DOREPLIFETIME_CONDITION(AShooterWeapon, ShotHistory, COND_SkipOwner);
 
 	DOREPLIFETIME(AShooterWeapon, MyPawn);
 
-	DOREPLIFETIME_CONDITION(AShooterWeapon, CurrentAmmo, COND_OwnerOnly);
-	DOREPLIFETIME_CONDITION(AShooterWeapon, CurrentAmmoInClip, COND_OwnerOnly);
+	DOREPLIFETIME_CONDITION(AShooterWeapon, AmmoState, COND_OwnerOnly);
 	DOREPLIFETIME_CONDITION(AShooterWeapon, BurstCounter, COND_SkipOwner);
 	DOREPLIFETIME_CONDITION(AShooterWeapon, bPendingReload, COND_SkipOwner);
 	
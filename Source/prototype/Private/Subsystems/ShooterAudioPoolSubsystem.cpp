@@ -0,0 +1,196 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Subsystems/ShooterAudioPoolSubsystem.h"
+#include "Engine/World.h"
+#include "Components/AudioComponent.h"
+#include "Sound/SoundBase.h"
+#include "../prototype.h"
+
+DECLARE_DWORD_COUNTER_STAT(TEXT("Audio Pool Hits"), STAT_AudioPoolHits, STATGROUP_Prototype);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Audio Pool Misses"), STAT_AudioPoolMisses, STATGROUP_Prototype);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Audio Pool Steals"), STAT_AudioPoolSteals, STATGROUP_Prototype);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Audio Pool Rejected"), STAT_AudioPoolRejected, STATGROUP_Prototype);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Audio Pool Voices"), STAT_AudioPoolVoices, STATGROUP_Prototype);
+
+static int32 AudioMaxVoices = 32;
+
+FAutoConsoleVariableRef CVARAudioMaxVoices(
+	TEXT("COOP.Audio.MaxVoices"),
+	AudioMaxVoices,
+	TEXT("Max pooled weapon sounds playing at once in the world"),
+	ECVF_Default);
+
+static int32 AudioMaxVoicesPerOwner = 4;
+
+FAutoConsoleVariableRef CVARAudioMaxVoicesPerOwner(
+	TEXT("COOP.Audio.MaxVoicesPerWeapon"),
+	AudioMaxVoicesPerOwner,
+	TEXT("Max pooled sounds playing at once per weapon, the oldest is cut beyond that"),
+	ECVF_Default);
+
+
+bool UShooterAudioPoolSubsystem::ShouldCreateSubsystem(UObject* Outer) const
+{
+	UWorld* World = Cast<UWorld>(Outer);
+	return World && World->IsGameWorld() && !IsRunningDedicatedServer();
+}
+
+
+void UShooterAudioPoolSubsystem::Deinitialize()
+{
+	for (UAudioComponent* Component : FreeComponents)
+	{
+		if (Component)
+		{
+			Component->DestroyComponent();
+		}
+	}
+	for (const FShooterAudioVoice& Voice : ActiveVoices)
+	{
+		if (Voice.Component)
+		{
+			Voice.Component->OnAudioFinishedNative.RemoveAll(this);
+			Voice.Component->DestroyComponent();
+		}
+	}
+	FreeComponents.Empty();
+	ActiveVoices.Empty();
+
+	SET_DWORD_STAT(STAT_AudioPoolVoices, 0);
+
+	Super::Deinitialize();
+}
+
+
+UAudioComponent* UShooterAudioPoolSubsystem::CreateComponent()
+{
+	UWorld* World = GetWorld();
+
+	UAudioComponent* Component = NewObject<UAudioComponent>(World);
+	Component->bAutoActivate = false;
+	Component->bAutoDestroy = false;
+	Component->bAllowSpatialization = true;
+	Component->OnAudioFinishedNative.AddUObject(this, &UShooterAudioPoolSubsystem::OnVoiceFinished);
+	Component->RegisterComponentWithWorld(World);
+
+	return Component;
+}
+
+
+int32 UShooterAudioPoolSubsystem::FindVoiceToSteal(const AActor* VoiceOwner) const
+{
+	for (int32 i = 0; i < ActiveVoices.Num(); i++)
+	{
+		const FShooterAudioVoice& Voice = ActiveVoices[i];
+		if (!Voice.bPersistent && (VoiceOwner == nullptr || Voice.VoiceOwner.Get() == VoiceOwner))
+		{
+			return i;
+		}
+	}
+
+	return INDEX_NONE;
+}
+
+
+UAudioComponent* UShooterAudioPoolSubsystem::PlayAttached(USoundBase* Sound, USceneComponent* AttachTo, const AActor* VoiceOwner, bool bPersistent)
+{
+	if (Sound == nullptr || AttachTo == nullptr || GetWorld()->GetNetMode() == NM_DedicatedServer)
+	{
+		return nullptr;
+	}
+
+	int32 OwnerVoices = 0;
+	for (const FShooterAudioVoice& Voice : ActiveVoices)
+	{
+		OwnerVoices += Voice.VoiceOwner.Get() == VoiceOwner ? 1 : 0;
+	}
+
+	/* Over a limit, the oldest voice of the same scope gives way to the new one */
+	bool bMustSteal = false;
+	int32 StealIndex = INDEX_NONE;
+	if (AudioMaxVoicesPerOwner > 0 && OwnerVoices >= AudioMaxVoicesPerOwner)
+	{
+		bMustSteal = true;
+		StealIndex = FindVoiceToSteal(VoiceOwner);
+	}
+	else if (AudioMaxVoices > 0 && ActiveVoices.Num() >= AudioMaxVoices)
+	{
+		bMustSteal = true;
+		StealIndex = FindVoiceToSteal(nullptr);
+	}
+
+	UAudioComponent* Component = nullptr;
+	if (bMustSteal)
+	{
+		if (StealIndex == INDEX_NONE)
+		{
+			/* Only persistent voices left in that scope */
+			INC_DWORD_STAT(STAT_AudioPoolRejected);
+			return nullptr;
+		}
+
+		/* Out of the active list first, so its finish notification doesn't free it */
+		Component = ActiveVoices[StealIndex].Component;
+		ActiveVoices.RemoveAt(StealIndex, 1, false);
+		Component->Stop();
+		INC_DWORD_STAT(STAT_AudioPoolSteals);
+	}
+	else if (FreeComponents.Num() > 0)
+	{
+		Component = FreeComponents.Pop(false);
+		INC_DWORD_STAT(STAT_AudioPoolHits);
+	}
+	else
+	{
+		Component = CreateComponent();
+		INC_DWORD_STAT(STAT_AudioPoolMisses);
+	}
+
+	FShooterAudioVoice& Voice = ActiveVoices.AddDefaulted_GetRef();
+	Voice.Component = Component;
+	Voice.VoiceOwner = VoiceOwner;
+	Voice.bPersistent = bPersistent;
+	SET_DWORD_STAT(STAT_AudioPoolVoices, ActiveVoices.Num());
+
+	Component->AttachToComponent(AttachTo, FAttachmentTransformRules::SnapToTargetNotIncludingScale);
+	Component->SetSound(Sound);
+	Component->Play();
+
+	return Component;
+}
+
+
+void UShooterAudioPoolSubsystem::OnVoiceFinished(UAudioComponent* Component)
+{
+	/* Finish notifications arrive from the audio thread a bit later, a stolen voice may already play its next sound */
+	if (Component && !Component->IsPlaying())
+	{
+		Release(Component);
+	}
+}
+
+
+void UShooterAudioPoolSubsystem::Release(UAudioComponent* Component)
+{
+	const int32 Index = ActiveVoices.IndexOfByPredicate([Component](const FShooterAudioVoice& Voice) { return Voice.Component == Component; });
+	if (Index == INDEX_NONE)
+	{
+		return;
+	}
+
+	ActiveVoices.RemoveAt(Index, 1, false);
+	SET_DWORD_STAT(STAT_AudioPoolVoices, ActiveVoices.Num());
+
+	if (Component->GetAttachParent())
+	{
+		Component->DetachFromComponent(FDetachmentTransformRules::KeepWorldTransform);
+	}
+	FreeComponents.Add(Component);
+}
+
+
+int32 UShooterAudioPoolSubsystem::GetNumActiveVoices() const
+{
+	return ActiveVoices.Num();
+}
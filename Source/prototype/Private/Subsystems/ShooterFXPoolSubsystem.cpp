@@ -0,0 +1,323 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Subsystems/ShooterFXPoolSubsystem.h"
+#include "Engine/World.h"
+#include "GameFramework/PlayerController.h"
+#include "Particles/ParticleSystem.h"
+#include "Particles/ParticleSystemComponent.h"
+#include "../prototype.h"
+
+DECLARE_DWORD_COUNTER_STAT(TEXT("FX Pool Hits"), STAT_FXPoolHits, STATGROUP_Prototype);
+DECLARE_DWORD_COUNTER_STAT(TEXT("FX Pool Misses"), STAT_FXPoolMisses, STATGROUP_Prototype);
+DECLARE_DWORD_COUNTER_STAT(TEXT("FX Pool Evictions"), STAT_FXPoolEvictions, STATGROUP_Prototype);
+DECLARE_DWORD_COUNTER_STAT(TEXT("FX Pool Culled"), STAT_FXPoolCulled, STATGROUP_Prototype);
+DECLARE_DWORD_COUNTER_STAT(TEXT("FX Pool Over Budget"), STAT_FXPoolOverBudget, STATGROUP_Prototype);
+DECLARE_DWORD_COUNTER_STAT(TEXT("FX Pool Active"), STAT_FXPoolActive, STATGROUP_Prototype);
+
+static int32 FXSpawnBudget = 32;
+
+FAutoConsoleVariableRef CVARFXSpawnBudget(
+	TEXT("COOP.FX.SpawnBudget"),
+	FXSpawnBudget,
+	TEXT("Max pooled particle effects started per frame, 0 for no limit"),
+	ECVF_Default);
+
+static int32 FXMaxPerTemplate = 24;
+
+FAutoConsoleVariableRef CVARFXMaxPerTemplate(
+	TEXT("COOP.FX.MaxPerTemplate"),
+	FXMaxPerTemplate,
+	TEXT("Max pooled components per particle template, the oldest playing one is recycled beyond that"),
+	ECVF_Default);
+
+static float FXCullDistance = 8000.0f;
+
+FAutoConsoleVariableRef CVARFXCullDistance(
+	TEXT("COOP.FX.CullDistance"),
+	FXCullDistance,
+	TEXT("Effects further than this from every local camera are not spawned"),
+	ECVF_Default);
+
+static float FXBehindViewRadius = 600.0f;
+
+FAutoConsoleVariableRef CVARFXBehindViewRadius(
+	TEXT("COOP.FX.BehindViewRadius"),
+	FXBehindViewRadius,
+	TEXT("Effects behind every local camera are still spawned within this distance"),
+	ECVF_Default);
+
+
+UShooterFXPoolSubsystem::UShooterFXPoolSubsystem()
+{
+	SpawnsThisFrame = 0;
+}
+
+
+bool UShooterFXPoolSubsystem::ShouldCreateSubsystem(UObject* Outer) const
+{
+	/* Dedicated servers never draw effects */
+	UWorld* World = Cast<UWorld>(Outer);
+	return World && World->IsGameWorld() && !IsRunningDedicatedServer();
+}
+
+
+void UShooterFXPoolSubsystem::Deinitialize()
+{
+	for (TPair<UParticleSystem*, FShooterFXPool>& Entry : Pools)
+	{
+		for (UParticleSystemComponent* Component : Entry.Value.Free)
+		{
+			if (Component)
+			{
+				Component->DestroyComponent();
+			}
+		}
+		for (UParticleSystemComponent* Component : Entry.Value.Active)
+		{
+			if (Component)
+			{
+				Component->DestroyComponent();
+			}
+		}
+	}
+	Pools.Empty();
+
+	Super::Deinitialize();
+}
+
+
+void UShooterFXPoolSubsystem::Prewarm(UParticleSystem* Template, int32 Count)
+{
+	if (Template == nullptr)
+	{
+		return;
+	}
+
+	FShooterFXPool& Pool = Pools.FindOrAdd(Template);
+	const int32 MaxCount = FXMaxPerTemplate > 0 ? FXMaxPerTemplate : MAX_int32;
+	while (Pool.Free.Num() + Pool.Active.Num() < FMath::Min(Count, MaxCount))
+	{
+		Pool.Free.Add(CreateComponent(Template));
+	}
+}
+
+
+UParticleSystemComponent* UShooterFXPoolSubsystem::CreateComponent(UParticleSystem* Template)
+{
+	UWorld* World = GetWorld();
+
+	UParticleSystemComponent* Component = NewObject<UParticleSystemComponent>(World);
+	Component->bAutoActivate = false;
+	Component->bAutoDestroy = false;
+	Component->bAllowAnyoneToDestroyMe = true;
+	Component->SecondsBeforeInactive = 0.0f;
+	Component->SetTemplate(Template);
+	Component->OnSystemFinished.AddDynamic(this, &UShooterFXPoolSubsystem::OnEffectFinished);
+	Component->RegisterComponentWithWorld(World);
+
+	return Component;
+}
+
+
+UParticleSystemComponent* UShooterFXPoolSubsystem::Acquire(UParticleSystem* Template)
+{
+	FShooterFXPool& Pool = Pools.FindOrAdd(Template);
+
+	UParticleSystemComponent* Component = nullptr;
+	if (Pool.Free.Num() > 0)
+	{
+		Component = Pool.Free.Pop(false);
+		INC_DWORD_STAT(STAT_FXPoolHits);
+	}
+	else if (FXMaxPerTemplate > 0 && Pool.Active.Num() >= FXMaxPerTemplate)
+	{
+		/* Out of components, the oldest effect is the least noticeable one to cut short */
+		Component = Pool.Active[0];
+		Pool.Active.RemoveAt(0, 1, false);
+		Component->DeactivateImmediate();
+		if (Component->GetAttachParent())
+		{
+			Component->DetachFromComponent(FDetachmentTransformRules::KeepWorldTransform);
+		}
+		INC_DWORD_STAT(STAT_FXPoolEvictions);
+	}
+	else
+	{
+		Component = CreateComponent(Template);
+		INC_DWORD_STAT(STAT_FXPoolMisses);
+	}
+
+	Pool.Active.Add(Component);
+	SpawnsThisFrame++;
+
+	return Component;
+}
+
+
+void UShooterFXPoolSubsystem::OnEffectFinished(UParticleSystemComponent* Component)
+{
+	FShooterFXPool* Pool = Component ? Pools.Find(Component->Template) : nullptr;
+	if (Pool == nullptr)
+	{
+		return;
+	}
+
+	/* An evicted component finishes while it is out of Active, it is reused right away and must not be freed */
+	if (Pool->Active.RemoveSingle(Component) > 0)
+	{
+		if (Component->GetAttachParent())
+		{
+			Component->DetachFromComponent(FDetachmentTransformRules::KeepWorldTransform);
+		}
+		Pool->Free.Add(Component);
+	}
+}
+
+
+bool UShooterFXPoolSubsystem::CanSpawn(const FVector& Start, const FVector& End)
+{
+	/* Also covers a dedicated server started in the same process as the editor */
+	if (GetWorld()->GetNetMode() == NM_DedicatedServer)
+	{
+		return false;
+	}
+
+	if (FXSpawnBudget > 0 && SpawnsThisFrame >= FXSpawnBudget)
+	{
+		INC_DWORD_STAT(STAT_FXPoolOverBudget);
+		return false;
+	}
+
+	/* No camera yet, don't cull anything */
+	if (ViewLocations.Num() == 0)
+	{
+		return true;
+	}
+
+	for (int32 i = 0; i < ViewLocations.Num(); i++)
+	{
+		const FVector& ViewLocation = ViewLocations[i];
+		const float DistSq = FMath::PointDistToSegmentSquared(ViewLocation, Start, End);
+		if (DistSq > FMath::Square(FXCullDistance))
+		{
+			continue;
+		}
+
+		/* Close effects stay even behind the camera, their light and smoke can still be seen */
+		const bool bInFront = ((Start - ViewLocation) | ViewDirections[i]) > 0.0f || ((End - ViewLocation) | ViewDirections[i]) > 0.0f;
+		if (bInFront || DistSq < FMath::Square(FXBehindViewRadius))
+		{
+			return true;
+		}
+	}
+
+	INC_DWORD_STAT(STAT_FXPoolCulled);
+	return false;
+}
+
+
+UParticleSystemComponent* UShooterFXPoolSubsystem::SpawnAtLocation(UParticleSystem* Template, const FVector& Location, const FRotator& Rotation)
+{
+	if (Template == nullptr || !CanSpawn(Location, Location))
+	{
+		return nullptr;
+	}
+
+	UParticleSystemComponent* Component = Acquire(Template);
+	Component->SetWorldLocationAndRotation(Location, Rotation);
+	Component->ActivateSystem(true);
+
+	return Component;
+}
+
+
+UParticleSystemComponent* UShooterFXPoolSubsystem::SpawnAttached(UParticleSystem* Template, USceneComponent* AttachTo, FName SocketName)
+{
+	if (Template == nullptr || AttachTo == nullptr)
+	{
+		return nullptr;
+	}
+
+	const FVector Location = AttachTo->GetSocketLocation(SocketName);
+	if (!CanSpawn(Location, Location))
+	{
+		return nullptr;
+	}
+
+	UParticleSystemComponent* Component = Acquire(Template);
+	Component->AttachToComponent(AttachTo, FAttachmentTransformRules::SnapToTargetIncludingScale, SocketName);
+	Component->ActivateSystem(true);
+
+	return Component;
+}
+
+
+UParticleSystemComponent* UShooterFXPoolSubsystem::SpawnBeam(UParticleSystem* Template, const FVector& Start, const FVector& End, FName TargetParameterName)
+{
+	if (Template == nullptr || !CanSpawn(Start, End))
+	{
+		return nullptr;
+	}
+
+	UParticleSystemComponent* Component = Acquire(Template);
+	Component->SetWorldLocationAndRotation(Start, FRotator::ZeroRotator);
+	Component->SetVectorParameter(TargetParameterName, End);
+	Component->ActivateSystem(true);
+
+	return Component;
+}
+
+
+void UShooterFXPoolSubsystem::Tick(float DeltaTime)
+{
+	SpawnsThisFrame = 0;
+
+	/* Views for next frame's culling, effects are spawned from actor ticks before this runs */
+	ViewLocations.Reset();
+	ViewDirections.Reset();
+	for (FConstPlayerControllerIterator It = GetWorld()->GetPlayerControllerIterator(); It; ++It)
+	{
+		APlayerController* PC = It->Get();
+		if (PC && PC->IsLocalController())
+		{
+			FVector ViewLocation;
+			FRotator ViewRotation;
+			PC->GetPlayerViewPoint(ViewLocation, ViewRotation);
+
+			ViewLocations.Add(ViewLocation);
+			ViewDirections.Add(ViewRotation.Vector());
+		}
+	}
+
+	int32 NumActive = 0;
+	for (const TPair<UParticleSystem*, FShooterFXPool>& Entry : Pools)
+	{
+		NumActive += Entry.Value.Active.Num();
+	}
+	SET_DWORD_STAT(STAT_FXPoolActive, NumActive);
+}
+
+
+ETickableTickType UShooterFXPoolSubsystem::GetTickableTickType() const
+{
+	return HasAnyFlags(RF_ClassDefaultObject) ? ETickableTickType::Never : ETickableTickType::Conditional;
+}
+
+
+bool UShooterFXPoolSubsystem::IsTickable() const
+{
+	return !IsTemplate();
+}
+
+
+TStatId UShooterFXPoolSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UShooterFXPoolSubsystem, STATGROUP_Tickables);
+}
+
+
+UWorld* UShooterFXPoolSubsystem::GetTickableGameObjectWorld() const
+{
+	return GetWorld();
+}
@@ -0,0 +1,332 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Subsystems/ShooterHitScanSubsystem.h"
+#include "Engine/World.h"
+#include "ShooterWeapon.h"
+#include "GameFramework/PlayerController.h"
+#include "../prototype.h"
+
+DECLARE_DWORD_COUNTER_STAT(TEXT("HitScan Queue Depth"), STAT_HitScanQueueDepth, STATGROUP_Prototype);
+DECLARE_DWORD_COUNTER_STAT(TEXT("HitScan Traces In Flight"), STAT_HitScanInFlight, STATGROUP_Prototype);
+DECLARE_FLOAT_COUNTER_STAT(TEXT("HitScan Latency (ms)"), STAT_HitScanLatency, STATGROUP_Prototype);
+
+
+UShooterHitScanSubsystem::UShooterHitScanSubsystem()
+{
+	NextRequestId = 1;
+	NextGroupId = 1;
+	ResolvedLatencySum = 0.0;
+	ResolvedCount = 0;
+}
+
+
+bool UShooterHitScanSubsystem::ShouldCreateSubsystem(UObject* Outer) const
+{
+	/* Editor preview worlds never fire weapons */
+	UWorld* World = Cast<UWorld>(Outer);
+	return World && World->IsGameWorld();
+}
+
+
+void UShooterHitScanSubsystem::Deinitialize()
+{
+	PendingRequests.Empty();
+	InFlightRequests.Empty();
+	PendingGroups.Empty();
+
+	Super::Deinitialize();
+}
+
+
+void UShooterHitScanSubsystem::QueueTrace(const FShooterHitScanRequest& Request)
+{
+	FShooterHitScanRequest& Pending = PendingRequests.Add_GetRef(Request);
+	Pending.QueuedTime = FPlatformTime::Seconds();
+}
+
+
+void UShooterHitScanSubsystem::QueueTraceGroup(TArrayView<const FShooterHitScanRequest> Requests)
+{
+	if (Requests.Num() == 0)
+	{
+		return;
+	}
+
+	const uint32 GroupId = NextGroupId++;
+	if (NextGroupId == 0)
+	{
+		NextGroupId = 1;
+	}
+
+	FShooterHitScanGroup& Group = PendingGroups.Add(GroupId);
+	Group.Requests.Append(Requests.GetData(), Requests.Num());
+	Group.Hits.SetNum(Requests.Num());
+	Group.NumPending = Requests.Num();
+
+	const double Now = FPlatformTime::Seconds();
+	for (int32 i = 0; i < Group.Requests.Num(); i++)
+	{
+		FShooterHitScanRequest& Request = Group.Requests[i];
+		Request.GroupId = GroupId;
+		Request.GroupIndex = i;
+		Request.QueuedTime = Now;
+
+		PendingRequests.Add(Request);
+	}
+}
+
+
+int32 UShooterHitScanSubsystem::GetNumPendingTraces() const
+{
+	return PendingRequests.Num();
+}
+
+
+int32 UShooterHitScanSubsystem::GetNumTracesInFlight() const
+{
+	return InFlightRequests.Num();
+}
+
+
+void UShooterHitScanSubsystem::Tick(float DeltaTime)
+{
+	SET_DWORD_STAT(STAT_HitScanQueueDepth, PendingRequests.Num());
+
+	/* Everything that fired this frame has been queued by now, actors tick before tickable objects */
+	FlushPendingTraces();
+
+	SET_DWORD_STAT(STAT_HitScanInFlight, InFlightRequests.Num());
+
+	if (ResolvedCount > 0)
+	{
+		SET_FLOAT_STAT(STAT_HitScanLatency, (ResolvedLatencySum / ResolvedCount) * 1000.0);
+
+		ResolvedLatencySum = 0.0;
+		ResolvedCount = 0;
+	}
+}
+
+
+void UShooterHitScanSubsystem::FlushPendingTraces()
+{
+	if (PendingRequests.Num() == 0)
+	{
+		return;
+	}
+
+	UWorld* World = GetWorld();
+
+	if (!TraceDelegate.IsBound())
+	{
+		TraceDelegate.BindUObject(this, &UShooterHitScanSubsystem::OnTraceCompleted);
+		OcclusionTraceDelegate.BindUObject(this, &UShooterHitScanSubsystem::OnOcclusionTraceCompleted);
+	}
+
+	/* Occlusion traces leave out every pawn by object type, however many targets there are */
+	FCollisionResponseParams OcclusionResponseParams;
+	OcclusionResponseParams.CollisionResponse.SetResponse(ECC_Pawn, ECR_Ignore);
+
+	for (const FShooterHitScanRequest& Request : PendingRequests)
+	{
+		AShooterWeapon* Weapon = Request.Weapon.Get();
+		if (Weapon == nullptr)
+		{
+			/* The rest of the group is skipped as well, don't wait for it */
+			PendingGroups.Remove(Request.GroupId);
+			continue;
+		}
+
+		/* Simple collision only, characters are hit through their physics asset bodies on the hitbox channel */
+		FCollisionQueryParams QueryParams(SCENE_QUERY_STAT(ShooterWeaponTrace), false);
+		QueryParams.AddIgnoredActor(Weapon->GetOwner());
+		QueryParams.AddIgnoredActor(Weapon);
+		QueryParams.bReturnPhysicalMaterial = true;
+
+		const uint32 RequestId = NextRequestId++;
+		if (NextRequestId == 0)
+		{
+			/* Zero is the async trace default, keep it free */
+			NextRequestId = 1;
+		}
+
+		FShooterHitScanInFlight& InFlight = InFlightRequests.Add(RequestId);
+		InFlight.Request = Request;
+		InFlight.NumPending = Request.bTraceOcclusion ? 2 : 1;
+
+		World->AsyncLineTraceByChannel(EAsyncTraceType::Single, Request.TraceStart, Request.TraceEnd, COLLISION_HITBOX, QueryParams,
+			FCollisionResponseParams::DefaultResponseParam, &TraceDelegate, RequestId);
+
+		if (Request.bTraceOcclusion)
+		{
+			World->AsyncLineTraceByChannel(EAsyncTraceType::Single, Request.TraceStart, Request.TraceEnd, COLLISION_HITBOX, QueryParams,
+				OcclusionResponseParams, &OcclusionTraceDelegate, RequestId);
+		}
+	}
+
+	PendingRequests.Reset();
+}
+
+
+void UShooterHitScanSubsystem::OnTraceCompleted(const FTraceHandle& Handle, FTraceDatum& Data)
+{
+	FShooterHitScanInFlight* InFlight = InFlightRequests.Find(Data.UserData);
+	if (InFlight == nullptr)
+	{
+		return;
+	}
+
+	const FHitResult* BlockingHit = Data.OutHits.FindByPredicate([](const FHitResult& Hit) { return Hit.bBlockingHit; });
+	InFlight->Hit = BlockingHit ? *BlockingHit : FHitResult();
+
+	if (--InFlight->NumPending == 0)
+	{
+		CompleteRequest(Data.UserData);
+	}
+}
+
+
+void UShooterHitScanSubsystem::OnOcclusionTraceCompleted(const FTraceHandle& Handle, FTraceDatum& Data)
+{
+	FShooterHitScanInFlight* InFlight = InFlightRequests.Find(Data.UserData);
+	if (InFlight == nullptr)
+	{
+		return;
+	}
+
+	const FHitResult* BlockingHit = Data.OutHits.FindByPredicate([](const FHitResult& Hit) { return Hit.bBlockingHit; });
+	InFlight->Request.OcclusionHit = BlockingHit ? *BlockingHit : FHitResult();
+
+	if (--InFlight->NumPending == 0)
+	{
+		CompleteRequest(Data.UserData);
+	}
+}
+
+
+void UShooterHitScanSubsystem::CompleteRequest(uint32 RequestId)
+{
+	FShooterHitScanInFlight InFlight;
+	if (!InFlightRequests.RemoveAndCopyValue(RequestId, InFlight))
+	{
+		return;
+	}
+
+	const FShooterHitScanRequest& Request = InFlight.Request;
+
+	ResolvedLatencySum += FPlatformTime::Seconds() - Request.QueuedTime;
+	ResolvedCount++;
+
+	if (Request.GroupId != 0)
+	{
+		FShooterHitScanGroup* Group = PendingGroups.Find(Request.GroupId);
+		if (Group == nullptr)
+		{
+			return;
+		}
+
+		Group->Requests[Request.GroupIndex].OcclusionHit = Request.OcclusionHit;
+		Group->Hits[Request.GroupIndex] = InFlight.Hit;
+		if (--Group->NumPending > 0)
+		{
+			return;
+		}
+
+		FShooterHitScanGroup CompletedGroup = MoveTemp(*Group);
+		PendingGroups.Remove(Request.GroupId);
+
+		AShooterWeapon* Weapon = Request.Weapon.Get();
+		if (Weapon)
+		{
+			Weapon->OnHitScanGroupCompleted(CompletedGroup.Requests, CompletedGroup.Hits);
+		}
+		return;
+	}
+
+	/* Weapon may have been destroyed while the trace was running */
+	AShooterWeapon* Weapon = Request.Weapon.Get();
+	if (Weapon == nullptr)
+	{
+		return;
+	}
+
+	Weapon->OnHitScanTraceCompleted(Request, InFlight.Hit);
+}
+
+
+static void RunHitScanBenchmark(const TArray<FString>& Args, UWorld* World)
+{
+	APlayerController* PC = World ? World->GetFirstPlayerController() : nullptr;
+	if (PC == nullptr)
+	{
+		return;
+	}
+
+	const int32 NumTraces = Args.Num() > 0 ? FMath::Max(1, FCString::Atoi(*Args[0])) : 1000;
+
+	FVector EyeLocation;
+	FRotator EyeRotation;
+	PC->GetPlayerViewPoint(EyeLocation, EyeRotation);
+
+	/* Same spread of rays for both runs, fanned around the current view */
+	FRandomStream Stream(NumTraces);
+	TArray<FVector> TraceEnds;
+	TraceEnds.SetNumUninitialized(NumTraces);
+	for (FVector& TraceEnd : TraceEnds)
+	{
+		TraceEnd = EyeLocation + Stream.VRandCone(EyeRotation.Vector(), FMath::DegreesToRadians(15.0f)) * 10000.0f;
+	}
+
+	auto TimeTraces = [&](ECollisionChannel Channel, bool bTraceComplex, int32& OutHits)
+	{
+		FCollisionQueryParams QueryParams(SCENE_QUERY_STAT(ShooterWeaponTraceBenchmark), bTraceComplex, PC->GetPawn());
+		QueryParams.bReturnPhysicalMaterial = true;
+
+		OutHits = 0;
+		const double StartTime = FPlatformTime::Seconds();
+		for (const FVector& TraceEnd : TraceEnds)
+		{
+			FHitResult Hit;
+			OutHits += World->LineTraceSingleByChannel(Hit, EyeLocation, TraceEnd, Channel, QueryParams) ? 1 : 0;
+		}
+		return (FPlatformTime::Seconds() - StartTime) * 1000000.0 / NumTraces;
+	};
+
+	int32 ComplexHits = 0;
+	int32 SimpleHits = 0;
+	const double ComplexCost = TimeTraces(COLLISION_WEAPON, true, ComplexHits);
+	const double SimpleCost = TimeTraces(COLLISION_HITBOX, false, SimpleHits);
+
+	UE_LOG(LogTemp, Log, TEXT("HitScan benchmark, %d traces: complex weapon channel %.2f us/trace (%d hits), simple hitbox channel %.2f us/trace (%d hits)"),
+		NumTraces, ComplexCost, ComplexHits, SimpleCost, SimpleHits);
+}
+
+FAutoConsoleCommandWithWorldAndArgs HitScanBenchmarkCommand(
+	TEXT("COOP.HitScan.Benchmark"),
+	TEXT("Time NumTraces (default 1000) weapon traces from the player's view, complex collision against the simple hitbox channel"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateStatic(&RunHitScanBenchmark),
+	ECVF_Cheat);
+
+
+ETickableTickType UShooterHitScanSubsystem::GetTickableTickType() const
+{
+	return HasAnyFlags(RF_ClassDefaultObject) ? ETickableTickType::Never : ETickableTickType::Conditional;
+}
+
+
+bool UShooterHitScanSubsystem::IsTickable() const
+{
+	return !IsTemplate();
+}
+
+
+TStatId UShooterHitScanSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UShooterHitScanSubsystem, STATGROUP_Tickables);
+}
+
+
+UWorld* UShooterHitScanSubsystem::GetTickableGameObjectWorld() const
+{
+	return GetWorld();
+}
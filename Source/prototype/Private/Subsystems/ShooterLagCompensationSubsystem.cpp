@@ -0,0 +1,83 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Subsystems/ShooterLagCompensationSubsystem.h"
+#include "Engine/World.h"
+
+
+static float ServerAnimAwakeTime = 2.0f;
+
+FAutoConsoleVariableRef CVARServerAnimAwakeTime(
+	TEXT("COOP.ServerAnim.AwakeTime"),
+	ServerAnimAwakeTime,
+	TEXT("Seconds a pose stays at full rate after combat nearby"),
+	ECVF_Default);
+
+
+bool UShooterLagCompensationSubsystem::ShouldCreateSubsystem(UObject* Outer) const
+{
+	UWorld* World = Cast<UWorld>(Outer);
+	return World && World->IsGameWorld();
+}
+
+
+void UShooterLagCompensationSubsystem::RegisterHistory(UShooterHitboxHistoryComponent* History)
+{
+	if (History)
+	{
+		Histories.AddUnique(History);
+	}
+}
+
+
+void UShooterLagCompensationSubsystem::UnregisterHistory(UShooterHitboxHistoryComponent* History)
+{
+	Histories.RemoveSwap(History);
+}
+
+
+void UShooterLagCompensationSubsystem::NotifyCombatActivity(const FVector& Start, const FVector& End, float Radius)
+{
+	/* Poses only sleep on dedicated servers */
+	if (GetWorld()->GetNetMode() != NM_DedicatedServer)
+	{
+		return;
+	}
+
+	const float AwakeUntil = GetWorld()->GetTimeSeconds() + ServerAnimAwakeTime;
+	const float RadiusSq = FMath::Square(Radius);
+
+	for (UShooterHitboxHistoryComponent* History : Histories)
+	{
+		if (History && FMath::PointDistToSegmentSquared(History->GetOwner()->GetActorLocation(), Start, End) <= RadiusSq)
+		{
+			History->WakePose(AwakeUntil);
+		}
+	}
+}
+
+
+bool UShooterLagCompensationSubsystem::RewindRayTest(float Time, const FVector& TraceStart, const FVector& TraceEnd, const AActor* IgnoreActor,
+	FShooterRewindHit& OutHit, UShooterHitboxHistoryComponent*& OutHistory) const
+{
+	OutHistory = nullptr;
+	OutHit.Distance = FLT_MAX;
+
+	for (UShooterHitboxHistoryComponent* History : Histories)
+	{
+		if (History == nullptr || History->GetOwner() == IgnoreActor)
+		{
+			continue;
+		}
+
+		/* Each history rejects the ray against its rewound bounds before touching individual hitboxes */
+		FShooterRewindHit CandidateHit;
+		if (History->RewindRayTest(Time, TraceStart, TraceEnd, CandidateHit) && CandidateHit.Distance < OutHit.Distance)
+		{
+			OutHit = CandidateHit;
+			OutHistory = History;
+		}
+	}
+
+	return OutHistory != nullptr;
+}
@@ -0,0 +1,172 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Subsystems/ShooterPawnRecyclerSubsystem.h"
+#include "Engine/World.h"
+#include "GameFramework/Pawn.h"
+#include "../prototype.h"
+
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Recycler Corpses"), STAT_RecyclerCorpses, STATGROUP_Prototype);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Recycler Pawns Reused"), STAT_RecyclerReused, STATGROUP_Prototype);
+
+static int32 RecyclerEnabled = 1;
+
+FAutoConsoleVariableRef CVARRecyclerEnabled(
+	TEXT("COOP.Recycler.Enabled"),
+	RecyclerEnabled,
+	TEXT("Reuse dead pawns for respawns and bot spawns instead of destroying them"),
+	ECVF_Default);
+
+static int32 RecyclerMaxCorpses = 16;
+
+FAutoConsoleVariableRef CVARRecyclerMaxCorpses(
+	TEXT("COOP.Recycler.MaxCorpses"),
+	RecyclerMaxCorpses,
+	TEXT("Max dead pawns kept for reuse per pawn class, the oldest of the class is destroyed when exceeded"),
+	ECVF_Default);
+
+
+bool UShooterPawnRecyclerSubsystem::ShouldCreateSubsystem(UObject* Outer) const
+{
+	UWorld* World = Cast<UWorld>(Outer);
+	return World && World->IsGameWorld();
+}
+
+
+void UShooterPawnRecyclerSubsystem::Deinitialize()
+{
+	Corpses.Empty();
+	RequestedClasses.Empty();
+
+	Super::Deinitialize();
+}
+
+
+bool UShooterPawnRecyclerSubsystem::RetirePawn(APawn* Pawn, float CorpseTime)
+{
+	if (!RecyclerEnabled || RecyclerMaxCorpses <= 0 || Pawn == nullptr || !Pawn->HasAuthority() || !Pawn->Implements<UShooterRecyclable>())
+	{
+		return false;
+	}
+
+	UClass* PawnClass = Pawn->GetClass();
+	if (!RequestedClasses.Contains(PawnClass))
+	{
+		return false;
+	}
+
+	if (Corpses.ContainsByPredicate([Pawn](const FCorpse& Corpse) { return Corpse.Pawn == Pawn; }))
+	{
+		return true;
+	}
+
+	FCorpse& Corpse = Corpses.AddDefaulted_GetRef();
+	Corpse.Pawn = Pawn;
+	Corpse.StoreTime = GetWorld()->GetTimeSeconds() + CorpseTime;
+	Corpse.bStored = false;
+
+	/* Capped per class, so one class dying in numbers can't push out the others. Least recently retired goes first. */
+	int32 NumOfClass = 0;
+	for (const FCorpse& Other : Corpses)
+	{
+		NumOfClass += (Other.Pawn.IsValid() && Other.Pawn->GetClass() == PawnClass) ? 1 : 0;
+	}
+
+	for (int32 i = 0; i < Corpses.Num() && NumOfClass > RecyclerMaxCorpses; )
+	{
+		APawn* Candidate = Corpses[i].Pawn.Get();
+		if (Candidate == nullptr || Candidate->GetClass() != PawnClass)
+		{
+			i++;
+			continue;
+		}
+
+		Corpses.RemoveAt(i, 1, false);
+		NumOfClass--;
+
+		Candidate->Destroy();
+	}
+
+	return true;
+}
+
+
+APawn* UShooterPawnRecyclerSubsystem::AcquirePawn(TSubclassOf<APawn> PawnClass, const FTransform& SpawnTransform)
+{
+	if (!RecyclerEnabled || PawnClass == nullptr)
+	{
+		return nullptr;
+	}
+
+	RequestedClasses.Add(PawnClass);
+
+	/* Corpses still on display aren't taken, the oldest stored one is */
+	const int32 Index = Corpses.IndexOfByPredicate([PawnClass](const FCorpse& Corpse)
+	{
+		return Corpse.bStored && Corpse.Pawn.IsValid() && Corpse.Pawn->GetClass() == PawnClass;
+	});
+
+	if (Index == INDEX_NONE)
+	{
+		return nullptr;
+	}
+
+	APawn* Pawn = Corpses[Index].Pawn.Get();
+	Corpses.RemoveAt(Index, 1, false);
+
+	Cast<IShooterRecyclable>(Pawn)->ResetForReuse(SpawnTransform);
+
+	INC_DWORD_STAT(STAT_RecyclerReused);
+
+	return Pawn;
+}
+
+
+void UShooterPawnRecyclerSubsystem::Tick(float DeltaTime)
+{
+	const float Now = GetWorld()->GetTimeSeconds();
+
+	for (int32 i = Corpses.Num() - 1; i >= 0; i--)
+	{
+		FCorpse& Corpse = Corpses[i];
+
+		APawn* Pawn = Corpse.Pawn.Get();
+		if (Pawn == nullptr || Pawn->IsPendingKill())
+		{
+			Corpses.RemoveAt(i, 1, false);
+			continue;
+		}
+
+		if (!Corpse.bStored && Now >= Corpse.StoreTime)
+		{
+			Corpse.bStored = true;
+			Cast<IShooterRecyclable>(Pawn)->StoreCorpse();
+		}
+	}
+
+	SET_DWORD_STAT(STAT_RecyclerCorpses, Corpses.Num());
+}
+
+
+ETickableTickType UShooterPawnRecyclerSubsystem::GetTickableTickType() const
+{
+	return HasAnyFlags(RF_ClassDefaultObject) ? ETickableTickType::Never : ETickableTickType::Conditional;
+}
+
+
+bool UShooterPawnRecyclerSubsystem::IsTickable() const
+{
+	return !IsTemplate();
+}
+
+
+TStatId UShooterPawnRecyclerSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UShooterPawnRecyclerSubsystem, STATGROUP_Tickables);
+}
+
+
+UWorld* UShooterPawnRecyclerSubsystem::GetTickableGameObjectWorld() const
+{
+	return GetWorld();
+}
@@ -0,0 +1,484 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Subsystems/ShooterProjectileSubsystem.h"
+#include "Engine/World.h"
+#include "Engine/StaticMesh.h"
+#include "Components/InstancedStaticMeshComponent.h"
+#include "GameFramework/Controller.h"
+#include "Kismet/GameplayStatics.h"
+#include "Sound/SoundCue.h"
+#include "ShooterProjectileWeapon.h"
+#include "Subsystems/ShooterFXPoolSubsystem.h"
+#include "../prototype.h"
+
+DECLARE_DWORD_COUNTER_STAT(TEXT("Projectiles Live"), STAT_ProjectilesLive, STATGROUP_Prototype);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Projectile Sweeps"), STAT_ProjectileSweeps, STATGROUP_Prototype);
+DECLARE_CYCLE_STAT(TEXT("Projectile Simulation"), STAT_ProjectileSimulation, STATGROUP_Prototype);
+DECLARE_CYCLE_STAT(TEXT("Projectile Proxies"), STAT_ProjectileProxies, STATGROUP_Prototype);
+
+static float ProjectileDetonationGrace = 0.5f;
+
+FAutoConsoleVariableRef CVARProjectileDetonationGrace(
+	TEXT("COOP.Projectile.DetonationGrace"),
+	ProjectileDetonationGrace,
+	TEXT("Time in seconds a client projectile waits for the server's detonation before exploding on its own"),
+	ECVF_Default);
+
+
+UShooterProjectileSubsystem::UShooterProjectileSubsystem()
+{
+	NextId = 1;
+	ProxyActor = nullptr;
+}
+
+
+bool UShooterProjectileSubsystem::ShouldCreateSubsystem(UObject* Outer) const
+{
+	UWorld* World = Cast<UWorld>(Outer);
+	return World && World->IsGameWorld();
+}
+
+
+void UShooterProjectileSubsystem::Deinitialize()
+{
+	const int32 Count = Positions.Num();
+	for (int32 i = Count - 1; i >= 0; i--)
+	{
+		RemoveProjectile(i);
+	}
+	PendingHits.Empty();
+	ProxyComponents.Empty();
+
+	if (ProxyActor)
+	{
+		ProxyActor->Destroy();
+		ProxyActor = nullptr;
+	}
+
+	Super::Deinitialize();
+}
+
+
+int32 UShooterProjectileSubsystem::RegisterProjectileType(const UClass* Key, const FShooterProjectileParams& Params)
+{
+	const int32* Existing = TypesByKey.Find(Key);
+	if (Existing)
+	{
+		return *Existing;
+	}
+
+	const int32 Type = Types.Add(Params);
+	TypesByKey.Add(Key, Type);
+	return Type;
+}
+
+
+void UShooterProjectileSubsystem::SpawnProjectile(int32 Type, const FVector& Location, const FVector& Velocity, float ElapsedTime, AShooterProjectileWeapon* Weapon,
+	int32 ShotId, AController* InstigatorController, bool bAuthoritative)
+{
+	if (!Types.IsValidIndex(Type))
+	{
+		return;
+	}
+
+	const FShooterProjectileParams& Params = Types[Type];
+
+	const uint32 Id = NextId++;
+	if (NextId == 0)
+	{
+		/* Zero is the async trace default, keep it free */
+		NextId = 1;
+	}
+
+	/* Catch up on the flight time the spawn spent on the wire, the trajectory is a closed-form parabola */
+	const FVector Acceleration(0.0f, 0.0f, GetWorld()->GetGravityZ() * Params.GravityScale);
+	const FVector CaughtUpLocation = Location + Velocity * ElapsedTime + Acceleration * (0.5f * ElapsedTime * ElapsedTime);
+
+	const int32 Index = Positions.Add(CaughtUpLocation);
+	PreviousPositions.Add(Location);
+	Velocities.Add(Velocity + Acceleration * ElapsedTime);
+	GravityScales.Add(Params.GravityScale);
+	Lifetimes.Add(Params.Lifetime > 0.0f ? Params.Lifetime - ElapsedTime : FLT_MAX);
+	Fuses.Add(Params.FuseTime > 0.0f ? Params.FuseTime - ElapsedTime : FLT_MAX);
+	TypeIndices.Add(Type);
+	Ids.Add(Id);
+	ShotIds.Add(ShotId);
+	Authoritative.Add(bAuthoritative);
+	AwaitingDetonation.Add(false);
+	Weapons.Add(Weapon);
+	InstigatorControllers.Add(InstigatorController);
+
+	IndexById.Add(Id, Index);
+}
+
+
+void UShooterProjectileSubsystem::DetonateProjectile(int32 Type, const AShooterProjectileWeapon* Weapon, int32 ShotId, const FVector& Location)
+{
+	/* Detonations are rare next to live projectiles, a scan over the packed shot ids is cheaper than another map */
+	const int32 Count = ShotIds.Num();
+	for (int32 i = 0; i < Count; i++)
+	{
+		if (ShotIds[i] == ShotId && Weapons[i].Get() == Weapon && !Authoritative[i])
+		{
+			PlayExplosionEffects(Types[TypeIndices[i]], Location);
+			RemoveProjectile(i);
+			return;
+		}
+	}
+
+	/* Spawn was lost or the copy already gave up waiting, the explosion is still worth showing */
+	if (Types.IsValidIndex(Type))
+	{
+		PlayExplosionEffects(Types[Type], Location);
+	}
+}
+
+
+int32 UShooterProjectileSubsystem::GetNumProjectiles() const
+{
+	return Positions.Num();
+}
+
+
+void UShooterProjectileSubsystem::RemoveProjectile(int32 Index)
+{
+	IndexById.Remove(Ids[Index]);
+
+	const int32 Last = Positions.Num() - 1;
+	if (Index != Last)
+	{
+		IndexById[Ids[Last]] = Index;
+	}
+
+	Positions.RemoveAtSwap(Index, 1, false);
+	PreviousPositions.RemoveAtSwap(Index, 1, false);
+	Velocities.RemoveAtSwap(Index, 1, false);
+	GravityScales.RemoveAtSwap(Index, 1, false);
+	Lifetimes.RemoveAtSwap(Index, 1, false);
+	Fuses.RemoveAtSwap(Index, 1, false);
+	TypeIndices.RemoveAtSwap(Index, 1, false);
+	Ids.RemoveAtSwap(Index, 1, false);
+	ShotIds.RemoveAtSwap(Index, 1, false);
+	Authoritative.RemoveAtSwap(Index, 1, false);
+	AwaitingDetonation.RemoveAtSwap(Index, 1, false);
+	Weapons.RemoveAtSwap(Index, 1, false);
+	InstigatorControllers.RemoveAtSwap(Index, 1, false);
+}
+
+
+void UShooterProjectileSubsystem::Explode(int32 Index)
+{
+	const FShooterProjectileParams& Params = Types[TypeIndices[Index]];
+	const FVector Location = Positions[Index];
+
+	if (!Authoritative[Index])
+	{
+		if (!AwaitingDetonation[Index])
+		{
+			/* Hold still and let the server decide where it went off */
+			AwaitingDetonation[Index] = true;
+			Velocities[Index] = FVector::ZeroVector;
+			GravityScales[Index] = 0.0f;
+			Fuses[Index] = FLT_MAX;
+			Lifetimes[Index] = ProjectileDetonationGrace;
+			return;
+		}
+
+		/* Server never confirmed, assume it went off where we predicted */
+		PlayExplosionEffects(Params, Location);
+		RemoveProjectile(Index);
+		return;
+	}
+
+	AShooterProjectileWeapon* Weapon = Weapons[Index].Get();
+
+	TArray<AActor*> IgnoreActors;
+	const float Damage = Params.ExplosionDamage * (Weapon ? Weapon->GetDamageMultiplier() : 1.0f);
+	UGameplayStatics::ApplyRadialDamage(GetWorld(), Damage, Location, Params.ExplosionRadius, Params.DamageType, IgnoreActors,
+		Weapon, InstigatorControllers[Index].Get(), true);
+
+	if (Weapon)
+	{
+		Weapon->MulticastDetonateProjectile(ShotIds[Index], Location);
+	}
+
+	PlayExplosionEffects(Params, Location);
+	RemoveProjectile(Index);
+}
+
+
+void UShooterProjectileSubsystem::PlayExplosionEffects(const FShooterProjectileParams& Params, const FVector& Location) const
+{
+#if !UE_SERVER
+	UWorld* World = GetWorld();
+	if (World->GetNetMode() == NM_DedicatedServer)
+	{
+		return;
+	}
+
+	UShooterFXPoolSubsystem* FXPool = World->GetSubsystem<UShooterFXPoolSubsystem>();
+	if (Params.ExplosionEffect && FXPool)
+	{
+		FXPool->SpawnAtLocation(Params.ExplosionEffect, Location);
+	}
+	if (Params.ExplosionSound)
+	{
+		UGameplayStatics::PlaySoundAtLocation(World, Params.ExplosionSound, Location);
+	}
+#endif
+}
+
+
+void UShooterProjectileSubsystem::Tick(float DeltaTime)
+{
+	{
+		SCOPE_CYCLE_COUNTER(STAT_ProjectileSimulation);
+
+		ResolvePendingHits();
+		Integrate(DeltaTime);
+		SubmitSweeps();
+	}
+
+	SET_DWORD_STAT(STAT_ProjectilesLive, Positions.Num());
+
+#if !UE_SERVER
+	if (GetWorld()->GetNetMode() != NM_DedicatedServer)
+	{
+		SCOPE_CYCLE_COUNTER(STAT_ProjectileProxies);
+		UpdateProxies();
+	}
+#endif
+}
+
+
+void UShooterProjectileSubsystem::ResolvePendingHits()
+{
+	for (const TPair<uint32, FHitResult>& Pending : PendingHits)
+	{
+		/* Projectile may have exploded on its fuse while the sweep was running */
+		const int32* IndexPtr = IndexById.Find(Pending.Key);
+		if (IndexPtr == nullptr)
+		{
+			continue;
+		}
+
+		const int32 Index = *IndexPtr;
+		if (AwaitingDetonation[Index])
+		{
+			continue;
+		}
+
+		const FHitResult& Hit = Pending.Value;
+		const FShooterProjectileParams& Params = Types[TypeIndices[Index]];
+
+		if (Params.bExplodeOnImpact)
+		{
+			Positions[Index] = Hit.Location;
+			Explode(Index);
+			continue;
+		}
+
+		/* Bounce off the surface and continue from the impact, the sweep result is one tick old */
+		const FVector Reflected = FMath::GetReflectionVector(Velocities[Index], Hit.ImpactNormal);
+		Velocities[Index] = Reflected * Params.Restitution;
+		Positions[Index] = Hit.Location + Hit.ImpactNormal * 0.1f;
+		PreviousPositions[Index] = Positions[Index];
+	}
+
+	PendingHits.Reset();
+}
+
+
+void UShooterProjectileSubsystem::Integrate(float DeltaTime)
+{
+	const int32 Count = Positions.Num();
+	if (Count == 0)
+	{
+		return;
+	}
+
+	const FVector Gravity(0.0f, 0.0f, GetWorld()->GetGravityZ() * DeltaTime);
+
+	/* One linear pass over each array, no per-projectile objects are touched */
+	for (int32 i = 0; i < Count; i++)
+	{
+		Velocities[i] += Gravity * GravityScales[i];
+	}
+
+	for (int32 i = 0; i < Count; i++)
+	{
+		Positions[i] += Velocities[i] * DeltaTime;
+	}
+
+	for (int32 i = 0; i < Count; i++)
+	{
+		Lifetimes[i] -= DeltaTime;
+		Fuses[i] -= DeltaTime;
+	}
+
+	/* Walk backwards so swap-removal never moves an unvisited projectile */
+	for (int32 i = Count - 1; i >= 0; i--)
+	{
+		if (Fuses[i] <= 0.0f || (AwaitingDetonation[i] && Lifetimes[i] <= 0.0f))
+		{
+			Explode(i);
+		}
+		else if (Lifetimes[i] <= 0.0f)
+		{
+			RemoveProjectile(i);
+		}
+	}
+}
+
+
+void UShooterProjectileSubsystem::SubmitSweeps()
+{
+	const int32 Count = Positions.Num();
+	SET_DWORD_STAT(STAT_ProjectileSweeps, Count);
+
+	if (Count == 0)
+	{
+		return;
+	}
+
+	if (!SweepDelegate.IsBound())
+	{
+		SweepDelegate.BindUObject(this, &UShooterProjectileSubsystem::OnSweepCompleted);
+	}
+
+	UWorld* World = GetWorld();
+
+	/* All sweeps go out together and resolve on the physics thread alongside the hitscan traces */
+	for (int32 i = 0; i < Count; i++)
+	{
+		if (AwaitingDetonation[i])
+		{
+			continue;
+		}
+
+		FCollisionQueryParams QueryParams(SCENE_QUERY_STAT(ShooterProjectileSweep), false);
+		AActor* Weapon = Weapons[i].Get();
+		if (Weapon)
+		{
+			QueryParams.AddIgnoredActor(Weapon);
+			QueryParams.AddIgnoredActor(Weapon->GetOwner());
+		}
+
+		const FCollisionShape Shape = FCollisionShape::MakeSphere(Types[TypeIndices[i]].CollisionRadius);
+
+		World->AsyncSweepByChannel(EAsyncTraceType::Single, PreviousPositions[i], Positions[i], FQuat::Identity, COLLISION_HITBOX, Shape, QueryParams,
+			FCollisionResponseParams::DefaultResponseParam, &SweepDelegate, Ids[i]);
+	}
+
+	/* Everything up to the current positions is swept now, the next sweeps start there */
+	FMemory::Memcpy(PreviousPositions.GetData(), Positions.GetData(), Count * sizeof(FVector));
+}
+
+
+void UShooterProjectileSubsystem::OnSweepCompleted(const FTraceHandle& Handle, FTraceDatum& Data)
+{
+	const FHitResult* BlockingHit = Data.OutHits.FindByPredicate([](const FHitResult& Hit) { return Hit.bBlockingHit; });
+	if (BlockingHit)
+	{
+		PendingHits.Emplace(Data.UserData, *BlockingHit);
+	}
+}
+
+
+void UShooterProjectileSubsystem::UpdateProxies()
+{
+	UWorld* World = GetWorld();
+
+	/* Gather the transforms of each proxy mesh, most weapons share one or two meshes */
+	TMap<UStaticMesh*, TArray<FTransform>> TransformsByMesh;
+	for (const FShooterProjectileParams& Params : Types)
+	{
+		if (Params.ProxyMesh)
+		{
+			TransformsByMesh.FindOrAdd(Params.ProxyMesh);
+		}
+	}
+
+	const int32 Count = Positions.Num();
+	for (int32 i = 0; i < Count; i++)
+	{
+		UStaticMesh* Mesh = Types[TypeIndices[i]].ProxyMesh;
+		if (Mesh)
+		{
+			const FQuat Rotation = Velocities[i].IsNearlyZero() ? FQuat::Identity : FRotationMatrix::MakeFromX(Velocities[i]).ToQuat();
+			TransformsByMesh[Mesh].Emplace(Rotation, Positions[i]);
+		}
+	}
+
+	for (TPair<UStaticMesh*, TArray<FTransform>>& Entry : TransformsByMesh)
+	{
+		UInstancedStaticMeshComponent* Instances = ProxyComponents.FindRef(Entry.Key);
+		if (Instances == nullptr)
+		{
+			if (Entry.Value.Num() == 0)
+			{
+				continue;
+			}
+
+			if (ProxyActor == nullptr)
+			{
+				FActorSpawnParameters SpawnParams;
+				SpawnParams.ObjectFlags |= RF_Transient;
+				ProxyActor = World->SpawnActor<AActor>(AActor::StaticClass(), FTransform::Identity, SpawnParams);
+
+				USceneComponent* Root = NewObject<USceneComponent>(ProxyActor);
+				ProxyActor->SetRootComponent(Root);
+				Root->RegisterComponent();
+			}
+
+			Instances = NewObject<UInstancedStaticMeshComponent>(ProxyActor);
+			Instances->SetStaticMesh(Entry.Key);
+			Instances->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+			Instances->SetupAttachment(ProxyActor->GetRootComponent());
+			Instances->RegisterComponent();
+
+			ProxyComponents.Add(Entry.Key, Instances);
+		}
+
+		/* Match the instance count, then move every instance in one batch */
+		const TArray<FTransform>& Transforms = Entry.Value;
+		while (Instances->GetInstanceCount() > Transforms.Num())
+		{
+			Instances->RemoveInstance(Instances->GetInstanceCount() - 1);
+		}
+		while (Instances->GetInstanceCount() < Transforms.Num())
+		{
+			Instances->AddInstanceWorldSpace(Transforms[Instances->GetInstanceCount()]);
+		}
+
+		if (Transforms.Num() > 0)
+		{
+			Instances->BatchUpdateInstancesTransforms(0, Transforms, true, true, true);
+		}
+	}
+}
+
+
+ETickableTickType UShooterProjectileSubsystem::GetTickableTickType() const
+{
+	return HasAnyFlags(RF_ClassDefaultObject) ? ETickableTickType::Never : ETickableTickType::Conditional;
+}
+
+
+bool UShooterProjectileSubsystem::IsTickable() const
+{
+	return !IsTemplate();
+}
+
+
+TStatId UShooterProjectileSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UShooterProjectileSubsystem, STATGROUP_Tickables);
+}
+
+
+UWorld* UShooterProjectileSubsystem::GetTickableGameObjectWorld() const
+{
+	return GetWorld();
+}
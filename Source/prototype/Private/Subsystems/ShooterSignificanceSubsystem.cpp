@@ -0,0 +1,292 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Subsystems/ShooterSignificanceSubsystem.h"
+#include "Engine/World.h"
+#include "GameFramework/PlayerController.h"
+#include "../prototype.h"
+
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Significance High"), STAT_SignificanceHigh, STATGROUP_Prototype);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Significance Medium"), STAT_SignificanceMedium, STATGROUP_Prototype);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Significance Low"), STAT_SignificanceLow, STATGROUP_Prototype);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Significance Dormant"), STAT_SignificanceDormant, STATGROUP_Prototype);
+DECLARE_CYCLE_STAT(TEXT("Significance Update"), STAT_SignificanceUpdate, STATGROUP_Prototype);
+
+static float SignificanceUpdateInterval = 0.25f;
+
+FAutoConsoleVariableRef CVARSignificanceUpdateInterval(
+	TEXT("COOP.Significance.UpdateInterval"),
+	SignificanceUpdateInterval,
+	TEXT("Seconds between significance updates"),
+	ECVF_Default);
+
+static float SignificanceHighDistance = 2000.0f;
+
+FAutoConsoleVariableRef CVARSignificanceHighDistance(
+	TEXT("COOP.Significance.HighDistance"),
+	SignificanceHighDistance,
+	TEXT("Actors closer than this to a player view are High"),
+	ECVF_Default);
+
+static float SignificanceMediumDistance = 5000.0f;
+
+FAutoConsoleVariableRef CVARSignificanceMediumDistance(
+	TEXT("COOP.Significance.MediumDistance"),
+	SignificanceMediumDistance,
+	TEXT("Actors closer than this to a player view are Medium"),
+	ECVF_Default);
+
+static float SignificanceLowDistance = 10000.0f;
+
+FAutoConsoleVariableRef CVARSignificanceLowDistance(
+	TEXT("COOP.Significance.LowDistance"),
+	SignificanceLowDistance,
+	TEXT("Actors closer than this to a player view are Low, the rest are Dormant"),
+	ECVF_Default);
+
+static float SignificanceBehindViewScale = 2.0f;
+
+FAutoConsoleVariableRef CVARSignificanceBehindViewScale(
+	TEXT("COOP.Significance.BehindViewScale"),
+	SignificanceBehindViewScale,
+	TEXT("Distance multiplier for actors behind a player view"),
+	ECVF_Default);
+
+static float SignificanceMediumTickInterval = 0.033f;
+
+FAutoConsoleVariableRef CVARSignificanceMediumTickInterval(
+	TEXT("COOP.Significance.MediumTickInterval"),
+	SignificanceMediumTickInterval,
+	TEXT("Tick interval of Medium actors"),
+	ECVF_Default);
+
+static float SignificanceLowTickInterval = 0.1f;
+
+FAutoConsoleVariableRef CVARSignificanceLowTickInterval(
+	TEXT("COOP.Significance.LowTickInterval"),
+	SignificanceLowTickInterval,
+	TEXT("Tick interval of Low actors"),
+	ECVF_Default);
+
+static float SignificanceDormantTickInterval = 0.25f;
+
+FAutoConsoleVariableRef CVARSignificanceDormantTickInterval(
+	TEXT("COOP.Significance.DormantTickInterval"),
+	SignificanceDormantTickInterval,
+	TEXT("Tick interval of Dormant actors"),
+	ECVF_Default);
+
+
+UShooterSignificanceSubsystem::UShooterSignificanceSubsystem()
+{
+	TimeSinceUpdate = 0.0f;
+}
+
+
+bool UShooterSignificanceSubsystem::ShouldCreateSubsystem(UObject* Outer) const
+{
+	UWorld* World = Cast<UWorld>(Outer);
+	return World && World->IsGameWorld();
+}
+
+
+void UShooterSignificanceSubsystem::Deinitialize()
+{
+	Entries.Empty();
+
+	Super::Deinitialize();
+}
+
+
+float UShooterSignificanceSubsystem::GetTickInterval(EShooterSignificance Significance)
+{
+	switch (Significance)
+	{
+	case EShooterSignificance::Medium:
+		return SignificanceMediumTickInterval;
+	case EShooterSignificance::Low:
+		return SignificanceLowTickInterval;
+	case EShooterSignificance::Dormant:
+		return SignificanceDormantTickInterval;
+	default:
+		return 0.0f;
+	}
+}
+
+
+float UShooterSignificanceSubsystem::GetThinkIntervalScale(EShooterSignificance Significance)
+{
+	switch (Significance)
+	{
+	case EShooterSignificance::Low:
+		return 2.0f;
+	case EShooterSignificance::Dormant:
+		return 4.0f;
+	default:
+		return 1.0f;
+	}
+}
+
+
+void UShooterSignificanceSubsystem::RegisterActor(AActor* Actor, const FShooterSignificanceChanged& OnChanged)
+{
+	if (Actor == nullptr || Entries.ContainsByPredicate([Actor](const FEntry& Entry) { return Entry.Actor == Actor; }))
+	{
+		return;
+	}
+
+	if (ViewLocations.Num() == 0)
+	{
+		GatherViews();
+	}
+
+	FEntry& Entry = Entries.AddDefaulted_GetRef();
+	Entry.Actor = Actor;
+	Entry.OnChanged = OnChanged;
+	Entry.Significance = ScoreActor(Actor);
+
+	Entry.OnChanged.ExecuteIfBound(Entry.Significance);
+}
+
+
+void UShooterSignificanceSubsystem::UnregisterActor(AActor* Actor)
+{
+	const int32 Index = Entries.IndexOfByPredicate([Actor](const FEntry& Entry) { return Entry.Actor == Actor; });
+	if (Index != INDEX_NONE)
+	{
+		Entries.RemoveAtSwap(Index, 1, false);
+	}
+}
+
+
+void UShooterSignificanceSubsystem::GatherViews()
+{
+	ViewLocations.Reset();
+	ViewDirections.Reset();
+
+	/* Clients only have their local players, the server has a controller for every player */
+	for (FConstPlayerControllerIterator It = GetWorld()->GetPlayerControllerIterator(); It; ++It)
+	{
+		APlayerController* PC = It->Get();
+		if (PC && (PC->IsLocalController() || PC->GetPawn()))
+		{
+			FVector ViewLocation;
+			FRotator ViewRotation;
+			PC->GetPlayerViewPoint(ViewLocation, ViewRotation);
+
+			ViewLocations.Add(ViewLocation);
+			ViewDirections.Add(ViewRotation.Vector());
+		}
+	}
+}
+
+
+EShooterSignificance UShooterSignificanceSubsystem::ScoreActor(const AActor* Actor) const
+{
+	/* No views (e.g. a server without players), nothing to rank against */
+	if (ViewLocations.Num() == 0)
+	{
+		return EShooterSignificance::Dormant;
+	}
+
+	const FVector Location = Actor->GetActorLocation();
+
+	float BestDistance = FLT_MAX;
+	for (int32 i = 0; i < ViewLocations.Num(); i++)
+	{
+		const FVector ToActor = Location - ViewLocations[i];
+		float Distance = ToActor.Size();
+		if ((ToActor | ViewDirections[i]) < 0.0f)
+		{
+			Distance *= SignificanceBehindViewScale;
+		}
+
+		BestDistance = FMath::Min(BestDistance, Distance);
+	}
+
+	if (BestDistance < SignificanceHighDistance)
+	{
+		return EShooterSignificance::High;
+	}
+	if (BestDistance < SignificanceMediumDistance)
+	{
+		return EShooterSignificance::Medium;
+	}
+	if (BestDistance < SignificanceLowDistance)
+	{
+		return EShooterSignificance::Low;
+	}
+	return EShooterSignificance::Dormant;
+}
+
+
+void UShooterSignificanceSubsystem::UpdateSignificance()
+{
+	SCOPE_CYCLE_COUNTER(STAT_SignificanceUpdate);
+
+	GatherViews();
+
+	int32 Counts[(int32)EShooterSignificance::MAX] = {};
+
+	for (int32 i = Entries.Num() - 1; i >= 0; i--)
+	{
+		AActor* Actor = Entries[i].Actor.Get();
+		if (Actor == nullptr)
+		{
+			Entries.RemoveAtSwap(i, 1, false);
+			continue;
+		}
+
+		const EShooterSignificance NewSignificance = ScoreActor(Actor);
+		Counts[(int32)NewSignificance]++;
+
+		if (NewSignificance != Entries[i].Significance)
+		{
+			Entries[i].Significance = NewSignificance;
+
+			/* Copy, the callback may unregister the actor */
+			FShooterSignificanceChanged OnChanged = Entries[i].OnChanged;
+			OnChanged.ExecuteIfBound(NewSignificance);
+		}
+	}
+
+	SET_DWORD_STAT(STAT_SignificanceHigh, Counts[(int32)EShooterSignificance::High]);
+	SET_DWORD_STAT(STAT_SignificanceMedium, Counts[(int32)EShooterSignificance::Medium]);
+	SET_DWORD_STAT(STAT_SignificanceLow, Counts[(int32)EShooterSignificance::Low]);
+	SET_DWORD_STAT(STAT_SignificanceDormant, Counts[(int32)EShooterSignificance::Dormant]);
+}
+
+
+void UShooterSignificanceSubsystem::Tick(float DeltaTime)
+{
+	TimeSinceUpdate += DeltaTime;
+	if (TimeSinceUpdate >= SignificanceUpdateInterval)
+	{
+		TimeSinceUpdate = 0.0f;
+		UpdateSignificance();
+	}
+}
+
+
+ETickableTickType UShooterSignificanceSubsystem::GetTickableTickType() const
+{
+	return HasAnyFlags(RF_ClassDefaultObject) ? ETickableTickType::Never : ETickableTickType::Conditional;
+}
+
+
+bool UShooterSignificanceSubsystem::IsTickable() const
+{
+	return !IsTemplate();
+}
+
+
+TStatId UShooterSignificanceSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UShooterSignificanceSubsystem, STATGROUP_Tickables);
+}
+
+
+UWorld* UShooterSignificanceSubsystem::GetTickableGameObjectWorld() const
+{
+	return GetWorld();
+}
@@ -0,0 +1,185 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Subsystems/ShooterUsableSubsystem.h"
+#include "Items/ShooterUsableActor.h"
+#include "Engine/World.h"
+#include "../prototype.h"
+
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Usables Registered"), STAT_UsablesRegistered, STATGROUP_Prototype);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Usable Range Queries"), STAT_UsableQueries, STATGROUP_Prototype);
+
+
+UShooterUsableSubsystem::UShooterUsableSubsystem()
+{
+	MaxUsableRadius = 0.0f;
+	CellSize = 500.0f;
+}
+
+
+bool UShooterUsableSubsystem::ShouldCreateSubsystem(UObject* Outer) const
+{
+	UWorld* World = Cast<UWorld>(Outer);
+	return World && World->IsGameWorld();
+}
+
+
+void UShooterUsableSubsystem::Deinitialize()
+{
+	for (const TPair<TWeakObjectPtr<AShooterUsableActor>, FIntPoint>& Entry : UsableCells)
+	{
+		AShooterUsableActor* Usable = Entry.Key.Get();
+		if (Usable && Usable->GetRootComponent())
+		{
+			Usable->GetRootComponent()->TransformUpdated.RemoveAll(this);
+		}
+	}
+
+	Cells.Empty();
+	UsableCells.Empty();
+	SET_DWORD_STAT(STAT_UsablesRegistered, 0);
+
+	Super::Deinitialize();
+}
+
+
+FIntPoint UShooterUsableSubsystem::GetCell(const FVector& Location) const
+{
+	return FIntPoint(FMath::FloorToInt(Location.X / CellSize), FMath::FloorToInt(Location.Y / CellSize));
+}
+
+
+void UShooterUsableSubsystem::RegisterUsable(AShooterUsableActor* Usable)
+{
+	if (Usable == nullptr || UsableCells.Contains(Usable))
+	{
+		return;
+	}
+
+	const FIntPoint Cell = GetCell(Usable->GetActorLocation());
+	Cells.FindOrAdd(Cell).Add(Usable);
+	UsableCells.Add(Usable, Cell);
+
+	USceneComponent* Root = Usable->GetRootComponent();
+	if (Root)
+	{
+		MaxUsableRadius = FMath::Max(MaxUsableRadius, Root->Bounds.SphereRadius);
+		Root->TransformUpdated.AddUObject(this, &UShooterUsableSubsystem::OnUsableMoved);
+	}
+
+	SET_DWORD_STAT(STAT_UsablesRegistered, UsableCells.Num());
+}
+
+
+void UShooterUsableSubsystem::UnregisterUsable(AShooterUsableActor* Usable)
+{
+	FIntPoint Cell;
+	if (Usable == nullptr || !UsableCells.RemoveAndCopyValue(Usable, Cell))
+	{
+		return;
+	}
+
+	TArray<TWeakObjectPtr<AShooterUsableActor>>* CellUsables = Cells.Find(Cell);
+	if (CellUsables)
+	{
+		CellUsables->RemoveSwap(Usable);
+		if (CellUsables->Num() == 0)
+		{
+			Cells.Remove(Cell);
+		}
+	}
+
+	if (Usable->GetRootComponent())
+	{
+		Usable->GetRootComponent()->TransformUpdated.RemoveAll(this);
+	}
+
+	SET_DWORD_STAT(STAT_UsablesRegistered, UsableCells.Num());
+}
+
+
+void UShooterUsableSubsystem::OnUsableMoved(USceneComponent* UpdatedComponent, EUpdateTransformFlags UpdateTransformFlags, ETeleportType Teleport)
+{
+	AShooterUsableActor* Usable = Cast<AShooterUsableActor>(UpdatedComponent->GetOwner());
+	FIntPoint* OldCell = Usable ? UsableCells.Find(Usable) : nullptr;
+	if (OldCell == nullptr)
+	{
+		return;
+	}
+
+	/* Most moves stay within the cell */
+	const FIntPoint NewCell = GetCell(Usable->GetActorLocation());
+	if (NewCell == *OldCell)
+	{
+		return;
+	}
+
+	TArray<TWeakObjectPtr<AShooterUsableActor>>* CellUsables = Cells.Find(*OldCell);
+	if (CellUsables)
+	{
+		CellUsables->RemoveSwap(Usable);
+		if (CellUsables->Num() == 0)
+		{
+			Cells.Remove(*OldCell);
+		}
+	}
+
+	Cells.FindOrAdd(NewCell).Add(Usable);
+	*OldCell = NewCell;
+}
+
+
+bool UShooterUsableSubsystem::IsUsableInRange(const AShooterUsableActor* Usable, const FVector& Location, float Radius) const
+{
+	const USceneComponent* Root = Usable ? Usable->GetRootComponent() : nullptr;
+	if (Root == nullptr)
+	{
+		return false;
+	}
+
+	const float Reach = Radius + Root->Bounds.SphereRadius;
+	return FVector::DistSquared(Root->Bounds.Origin, Location) <= FMath::Square(Reach);
+}
+
+
+void UShooterUsableSubsystem::GatherUsablesInRange(const FVector& Location, float Radius, TArray<AShooterUsableActor*>& OutUsables) const
+{
+	INC_DWORD_STAT(STAT_UsableQueries);
+
+	if (UsableCells.Num() == 0)
+	{
+		return;
+	}
+
+	const float Reach = Radius + MaxUsableRadius;
+	const FIntPoint MinCell = GetCell(Location - FVector(Reach, Reach, 0.0f));
+	const FIntPoint MaxCell = GetCell(Location + FVector(Reach, Reach, 0.0f));
+
+	for (int32 X = MinCell.X; X <= MaxCell.X; X++)
+	{
+		for (int32 Y = MinCell.Y; Y <= MaxCell.Y; Y++)
+		{
+			const TArray<TWeakObjectPtr<AShooterUsableActor>>* CellUsables = Cells.Find(FIntPoint(X, Y));
+			if (CellUsables == nullptr)
+			{
+				continue;
+			}
+
+			for (const TWeakObjectPtr<AShooterUsableActor>& Usable : *CellUsables)
+			{
+				if (IsUsableInRange(Usable.Get(), Location, Radius))
+				{
+					OutUsables.Add(Usable.Get());
+				}
+			}
+		}
+	}
+}
+
+
+bool UShooterUsableSubsystem::HasUsableInRange(const FVector& Location, float Radius) const
+{
+	TArray<AShooterUsableActor*> Usables;
+	GatherUsablesInRange(Location, Radius, Usables);
+	return Usables.Num() > 0;
+}
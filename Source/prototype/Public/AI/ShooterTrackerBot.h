@@ -4,14 +4,18 @@
 
 #include "CoreMinimal.h"
 #include "GameFramework/Pawn.h"
+#include "Subsystems/ShooterSignificanceSubsystem.h"
+#include "Subsystems/ShooterPawnRecyclerSubsystem.h"
 #include "ShooterTrackerBot.generated.h"
 
 class UShooterHealthComponent;
+struct FShooterHealthChange;
+class UShooterHitboxHistoryComponent;
 class USphereComponent;
 class USoundCue;
 
 UCLASS()
-class PROTOTYPE_API AShooterTrackerBot : public APawn
+class PROTOTYPE_API AShooterTrackerBot : public APawn, public IShooterRecyclable
 {
 	GENERATED_BODY()
 
@@ -23,6 +27,14 @@ protected:
 	// Called when the game starts or when spawned
 	virtual void BeginPlay() override;
 
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+	/* Scale tick and think rate with distance to the players */
+	void OnSignificanceChanged(EShooterSignificance NewSignificance);
+
+	/* Multiplier for the path refresh and power level timers, from the significance tier */
+	float ThinkIntervalScale;
+
 	UPROPERTY(VisibleDefaultsOnly, Category = "Components")
 	UStaticMeshComponent* MeshComp;
 
@@ -32,9 +44,10 @@ protected:
 	UPROPERTY(VisibleDefaultsOnly, Category = "Components")
 	USphereComponent* SphereComp;
 
-	UFUNCTION()
-	void HandleTakeDamage(UShooterHealthComponent* OwningHealthComp, float Health, float HealthDelta, const class UDamageType* DamageType
-		, class AController* InstigatedBy, AActor* DamageCauser);
+	UPROPERTY(VisibleDefaultsOnly, Category = "Components")
+	UShooterHitboxHistoryComponent* HitboxHistoryComp;
+
+	void HandleTakeDamage(const FShooterHealthChange& Change);
 
 	FVector GetNextPathPoint();
 
@@ -55,6 +68,9 @@ protected:
 
 	void SelfDestruct();
 
+	/* Undo the explosion, runs wherever health comes back after a reuse */
+	void RestoreFromExplosion();
+
 	UPROPERTY(EditDefaultsOnly, Category = "TrackerBot")
 	UParticleSystem* ExplosionEffect;
 
@@ -87,6 +103,14 @@ public:
 
 	virtual void NotifyActorBeginOverlap(AActor* OtherActor) override;
 
+	/************************************************************************/
+	/* IShooterRecyclable                                                   */
+	/************************************************************************/
+
+	virtual void StoreCorpse() override;
+
+	virtual void ResetForReuse(const FTransform& SpawnTransform) override;
+
 protected:
 
 	// CHALLENGE CODE	
@@ -99,5 +123,7 @@ protected:
 
 	FTimerHandle TimerHandle_RefreshPath;
 
+	FTimerHandle TimerHandle_CheckPowerLevel;
+
 	void RefreshPath();
 };
@@ -0,0 +1,115 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Animation/AnimInstance.h"
+#include "Animation/AnimInstanceProxy.h"
+#include "ShooterCharacter.h"
+#include "ShooterAnimInstance.generated.h"
+
+class UShooterAnimInstance;
+
+
+/**
+ * Animation state of a shooter character. The game thread copies the character's state in PreUpdate,
+ * everything derived from it is computed in Update on an animation worker thread.
+ * The anim graph reads these members directly (fast path), no Blueprint runs during the update.
+ */
+USTRUCT(BlueprintType)
+struct PROTOTYPE_API FShooterAnimInstanceProxy : public FAnimInstanceProxy
+{
+	GENERATED_BODY()
+
+public:
+
+	FShooterAnimInstanceProxy();
+
+	FShooterAnimInstanceProxy(UAnimInstance* Instance);
+
+	UPROPERTY(Transient, BlueprintReadOnly, Category = "Character")
+	EPlayerPose PlayerPose;
+
+	UPROPERTY(Transient, BlueprintReadOnly, Category = "Character")
+	bool bIsSprinting;
+
+	UPROPERTY(Transient, BlueprintReadOnly, Category = "Character")
+	bool bIsTargeting;
+
+	UPROPERTY(Transient, BlueprintReadOnly, Category = "Character")
+	bool bIsInitiatedJump;
+
+	UPROPERTY(Transient, BlueprintReadOnly, Category = "Character")
+	bool bIsFalling;
+
+	/* Aim pitch/yaw relative to the actor, same as AShooterCharacter::GetAimOffsets */
+	UPROPERTY(Transient, BlueprintReadOnly, Category = "Character")
+	float AimPitch;
+
+	UPROPERTY(Transient, BlueprintReadOnly, Category = "Character")
+	float AimYaw;
+
+	UPROPERTY(Transient, BlueprintReadOnly, Category = "Character")
+	float Speed;
+
+	/* Movement direction relative to the actor's facing, -180..180 */
+	UPROPERTY(Transient, BlueprintReadOnly, Category = "Character")
+	float Direction;
+
+	/* Foot placement from UShooterFootIKComponent, already scaled by its blend alpha */
+	UPROPERTY(Transient, BlueprintReadOnly, Category = "FootIK")
+	float LeftFootOffset;
+
+	UPROPERTY(Transient, BlueprintReadOnly, Category = "FootIK")
+	float RightFootOffset;
+
+	UPROPERTY(Transient, BlueprintReadOnly, Category = "FootIK")
+	FRotator LeftFootRotation;
+
+	UPROPERTY(Transient, BlueprintReadOnly, Category = "FootIK")
+	FRotator RightFootRotation;
+
+	UPROPERTY(Transient, BlueprintReadOnly, Category = "FootIK")
+	float HipOffset;
+
+protected:
+
+	/* Game thread, copy what the update needs from the character */
+	virtual void PreUpdate(UAnimInstance* InAnimInstance, float DeltaSeconds) override;
+
+	/* Worker thread, must not touch the character */
+	virtual void Update(float DeltaSeconds) override;
+
+	/* Raw values copied in PreUpdate */
+	FRotator BaseAimRotation;
+
+	FVector Velocity;
+
+	FTransform ActorTransform;
+};
+
+
+/**
+ * Native base for the character anim blueprint. Replaces the event graph that queried the character every frame,
+ * so animation can update and evaluate on worker threads. Blueprints using this class should leave
+ * the event graph empty and keep "Use Multi Threaded Animation Update" enabled.
+ */
+UCLASS(Transient, Blueprintable)
+class PROTOTYPE_API UShooterAnimInstance : public UAnimInstance
+{
+	GENERATED_BODY()
+
+public:
+
+	UShooterAnimInstance(const FObjectInitializer& ObjectInitializer);
+
+protected:
+
+	virtual FAnimInstanceProxy* CreateAnimInstanceProxy() override;
+
+	/* Proxy is a member, nothing to free */
+	virtual void DestroyAnimInstanceProxy(FAnimInstanceProxy* InProxy) override;
+
+	UPROPERTY(Transient, BlueprintReadOnly, Category = "Animation", meta = (AllowPrivateAccess = "true"))
+	FShooterAnimInstanceProxy Proxy;
+};
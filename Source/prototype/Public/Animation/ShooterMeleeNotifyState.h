@@ -0,0 +1,57 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Animation/AnimNotifies/AnimNotifyState.h"
+#include "ShooterMeleeNotifyState.generated.h"
+
+class UDamageType;
+class UShooterMeleeComponent;
+
+/**
+ * Hit window of a melee attack. While the window is open the owner's melee component sweeps
+ * the segment between StartSocket and EndSocket every frame. Notify objects are shared between
+ * all meshes playing the animation, so all swing state lives on the component.
+ */
+UCLASS(meta = (DisplayName = "Melee Hit Window"))
+class PROTOTYPE_API UShooterMeleeNotifyState : public UAnimNotifyState
+{
+	GENERATED_BODY()
+
+public:
+
+	UShooterMeleeNotifyState();
+
+	virtual void NotifyBegin(USkeletalMeshComponent* MeshComp, UAnimSequenceBase* Animation, float TotalDuration) override;
+
+	virtual void NotifyTick(USkeletalMeshComponent* MeshComp, UAnimSequenceBase* Animation, float FrameDeltaTime) override;
+
+	virtual void NotifyEnd(USkeletalMeshComponent* MeshComp, UAnimSequenceBase* Animation) override;
+
+	virtual FString GetNotifyName_Implementation() const override;
+
+protected:
+
+	static UShooterMeleeComponent* GetMeleeComponent(USkeletalMeshComponent* MeshComp);
+
+	/* Sample the sockets on the equipped weapon's mesh (katana) instead of the character's (fists) */
+	UPROPERTY(EditAnywhere, Category = "Melee")
+	bool bTraceWeaponMesh;
+
+	UPROPERTY(EditAnywhere, Category = "Melee")
+	FName StartSocket;
+
+	/* None sweeps a sphere around StartSocket */
+	UPROPERTY(EditAnywhere, Category = "Melee")
+	FName EndSocket;
+
+	UPROPERTY(EditAnywhere, Category = "Melee", meta = (ClampMin = 1.0f))
+	float Radius;
+
+	UPROPERTY(EditAnywhere, Category = "Melee")
+	float Damage;
+
+	UPROPERTY(EditAnywhere, Category = "Melee")
+	TSubclassOf<UDamageType> DamageType;
+};
@@ -0,0 +1,178 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Components/ActorComponent.h"
+#include "Net/Serialization/FastArraySerializer.h"
+#include "ShooterAttributeComponent.generated.h"
+
+
+/* Values modifiers act on. All of them are multipliers with a base of 1. */
+UENUM(BlueprintType)
+enum class EShooterAttribute : uint8
+{
+	MoveSpeed,
+	Damage,
+	FireRate,
+	MAX UMETA(Hidden)
+};
+
+
+UENUM(BlueprintType)
+enum class EShooterModifierOp : uint8
+{
+	/* Added to the base value */
+	Add,
+	/* Multiplies base plus all adds */
+	Multiply,
+	/* Replaces the result, the newest override wins */
+	Override,
+};
+
+
+/* One active modifier */
+USTRUCT(BlueprintType)
+struct FShooterAttributeModifier : public FFastArraySerializerItem
+{
+	GENERATED_BODY()
+
+public:
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Attributes")
+	EShooterAttribute Attribute;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Attributes")
+	EShooterModifierOp Op;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Attributes")
+	float Magnitude;
+
+	/* Assigned when added, increases with every modifier so overrides can be ordered */
+	UPROPERTY()
+	int32 Handle;
+
+	FShooterAttributeModifier()
+		: Attribute(EShooterAttribute::MoveSpeed)
+		, Op(EShooterModifierOp::Multiply)
+		, Magnitude(1.0f)
+		, Handle(INDEX_NONE)
+	{
+	}
+
+	bool NetSerialize(FArchive& Ar, class UPackageMap* Map, bool& bOutSuccess);
+};
+
+template<>
+struct TStructOpsTypeTraits<FShooterAttributeModifier> : public TStructOpsTypeTraitsBase2<FShooterAttributeModifier>
+{
+	enum
+	{
+		WithNetSerializer = true,
+	};
+};
+
+
+/* Active modifiers of a component, replicated as a fast array so only added, changed and removed entries are sent */
+USTRUCT()
+struct FShooterModifierList : public FFastArraySerializer
+{
+	GENERATED_BODY()
+
+public:
+
+	FShooterModifierList()
+		: OwnerComponent(nullptr)
+	{
+	}
+
+	void PostReplicatedAdd(const TArrayView<int32>& AddedIndices, int32 FinalSize);
+
+	void PostReplicatedChange(const TArrayView<int32>& ChangedIndices, int32 FinalSize);
+
+	void PreReplicatedRemove(const TArrayView<int32>& RemovedIndices, int32 FinalSize);
+
+	bool NetDeltaSerialize(FNetDeltaSerializeInfo& DeltaParms)
+	{
+		return FFastArraySerializer::FastArrayDeltaSerialize<FShooterAttributeModifier, FShooterModifierList>(Modifiers, DeltaParms, *this);
+	}
+
+	UPROPERTY()
+	TArray<FShooterAttributeModifier> Modifiers;
+
+	UPROPERTY(NotReplicated)
+	class UShooterAttributeComponent* OwnerComponent;
+};
+
+template<>
+struct TStructOpsTypeTraits<FShooterModifierList> : public TStructOpsTypeTraitsBase2<FShooterModifierList>
+{
+	enum
+	{
+		WithNetDeltaSerializer = true,
+	};
+};
+
+
+/**
+ * Attribute values of the owner with stackable modifiers (powerups etc.). Values are aggregated lazily when a
+ * modifier changes and cached in between, so readers like GetMaxSpeed can query them as often as they like.
+ * Modifiers are added on the server and replicate to the owning client only, which predicts with them.
+ */
+UCLASS( ClassGroup=(PROTOTYPE), meta=(BlueprintSpawnableComponent) )
+class PROTOTYPE_API UShooterAttributeComponent : public UActorComponent
+{
+	GENERATED_BODY()
+
+public:
+
+	UShooterAttributeComponent();
+
+	/* Current value including all modifiers */
+	UFUNCTION(BlueprintCallable, Category = "Attributes")
+	float GetValue(EShooterAttribute Attribute) const
+	{
+		/* Blueprint can pass MAX, report it unmodified */
+		if (Attribute >= EShooterAttribute::MAX)
+		{
+			return 1.0f;
+		}
+
+		if (bDirty)
+		{
+			Aggregate();
+		}
+		return CachedValues[(int32)Attribute];
+	}
+
+	/* Returns a handle for RemoveModifier */
+	UFUNCTION(BlueprintCallable, BlueprintAuthorityOnly, Category = "Attributes")
+	int32 AddModifier(EShooterAttribute Attribute, EShooterModifierOp Op, float Magnitude);
+
+	UFUNCTION(BlueprintCallable, BlueprintAuthorityOnly, Category = "Attributes")
+	void RemoveModifier(int32 Handle);
+
+	/* Server, drop every modifier, e.g. when the owner is reused after death. Handles given out before stay invalid. */
+	void ClearModifiers();
+
+	/* Modifier list changed, values are recomputed on the next read */
+	void MarkDirty()
+	{
+		bDirty = true;
+	}
+
+protected:
+
+	virtual void BeginPlay() override;
+
+	void Aggregate() const;
+
+	UPROPERTY(Replicated)
+	FShooterModifierList ActiveModifiers;
+
+	int32 NextHandle;
+
+	mutable float CachedValues[(int32)EShooterAttribute::MAX];
+
+	mutable bool bDirty;
+};
@@ -0,0 +1,131 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Components/ActorComponent.h"
+#include "WorldCollision.h"
+#include "ShooterFootIKComponent.generated.h"
+
+class USkeletalMeshComponent;
+
+
+/**
+ * Foot placement for the owner's skeletal mesh. Ground under each foot is found with async traces issued
+ * one frame ahead, results are reused while the owner stands still. The anim instance reads the offsets,
+ * the owner turns IK off for distant characters, which blends it out and stops the tick.
+ */
+UCLASS( ClassGroup=(PROTOTYPE), meta=(BlueprintSpawnableComponent) )
+class PROTOTYPE_API UShooterFootIKComponent : public UActorComponent
+{
+	GENERATED_BODY()
+
+public:
+
+	UShooterFootIKComponent();
+
+	virtual void TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction) override;
+
+	/* Blend IK in or out, disabled IK stops tracing and ticking once fully blended out */
+	void SetIKEnabled(bool bEnabled);
+
+	float GetLeftFootOffset() const
+	{
+		return Feet[0].Offset * Alpha;
+	}
+
+	float GetRightFootOffset() const
+	{
+		return Feet[1].Offset * Alpha;
+	}
+
+	FRotator GetLeftFootRotation() const
+	{
+		return Feet[0].Rotation * Alpha;
+	}
+
+	FRotator GetRightFootRotation() const
+	{
+		return Feet[1].Rotation * Alpha;
+	}
+
+	/* Pelvis drop so the lower foot can reach the ground, zero or negative */
+	float GetHipOffset() const
+	{
+		return HipOffset * Alpha;
+	}
+
+protected:
+
+	virtual void BeginPlay() override;
+
+	struct FFoot
+	{
+		FName Socket;
+
+		/* Latest trace result, relative to the bottom of the capsule */
+		float TargetOffset;
+
+		FRotator TargetRotation;
+
+		/* Interpolated towards the targets every tick */
+		float Offset;
+
+		FRotator Rotation;
+
+		bool bTracePending;
+	};
+
+	void RequestTraces();
+
+	void OnTraceCompleted(const FTraceHandle& Handle, FTraceDatum& Data);
+
+	/* Z of the bottom of the owner's capsule (or its root) */
+	float GetGroundZ() const;
+
+	UPROPERTY(EditDefaultsOnly, Category = "FootIK")
+	FName LeftFootSocket;
+
+	UPROPERTY(EditDefaultsOnly, Category = "FootIK")
+	FName RightFootSocket;
+
+	/* How far above the capsule bottom a foot may be raised */
+	UPROPERTY(EditDefaultsOnly, Category = "FootIK", meta = (ClampMin = 0.0f))
+	float TraceUpDistance;
+
+	/* How far below the capsule bottom a foot may be lowered */
+	UPROPERTY(EditDefaultsOnly, Category = "FootIK", meta = (ClampMin = 0.0f))
+	float TraceDownDistance;
+
+	UPROPERTY(EditDefaultsOnly, Category = "FootIK", meta = (ClampMin = 0.0f))
+	float InterpSpeed;
+
+	/* Alpha per second when IK is turned on or off */
+	UPROPERTY(EditDefaultsOnly, Category = "FootIK", meta = (ClampMin = 0.0f))
+	float BlendSpeed;
+
+	/* Owner counts as standing still below this speed and keeps the last trace results */
+	UPROPERTY(EditDefaultsOnly, Category = "FootIK", meta = (ClampMin = 0.0f))
+	float StationarySpeed;
+
+	UPROPERTY(Transient)
+	USkeletalMeshComponent* SkeletalMesh;
+
+	FFoot Feet[2];
+
+	float HipOffset;
+
+	float Alpha;
+
+	bool bIKEnabled;
+
+	/* Mesh runs a UShooterAnimInstance, the only anim instance that reads our offsets */
+	bool bHasIKReader;
+
+	/* Owner location of the last traces, a stationary owner that moved (e.g. was pushed) traces again */
+	FVector LastTraceLocation;
+
+	bool bHasTraceResults;
+
+	FTraceDelegate TraceDelegate;
+};
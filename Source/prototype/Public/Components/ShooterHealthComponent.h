@@ -6,9 +6,30 @@
 #include "Components/ActorComponent.h"
 #include "ShooterHealthComponent.generated.h"
 
+class UShooterHealthComponent;
+
 //OnHealthChanged event
 DECLARE_DYNAMIC_MULTICAST_DELEGATE_SixParams(FOnHealthChangedSignature, UShooterHealthComponent*, HealthComp, float, Health, float, HealthDelta, const class UDamageType*, DamageType, class AController*, InstigatedBy, AActor*, DamageCauser);
 
+/* Everything about a health change, passed by reference to native listeners */
+struct FShooterHealthChange
+{
+	UShooterHealthComponent* HealthComp;
+
+	float Health;
+
+	/* Damage taken, negative when healed */
+	float HealthDelta;
+
+	const class UDamageType* DamageType;
+
+	class AController* InstigatedBy;
+
+	AActor* DamageCauser;
+};
+
+DECLARE_MULTICAST_DELEGATE_OneParam(FOnHealthChangedNative, const FShooterHealthChange&);
+
 UCLASS( ClassGroup=(PROTOTYPE), meta=(BlueprintSpawnableComponent) )
 class PROTOTYPE_API UShooterHealthComponent : public UActorComponent
 {
@@ -39,16 +60,44 @@ protected:
 	UFUNCTION()
 	void HandleTakeAnyDamage(AActor* DamagedActor, float Damage, const class UDamageType* DamageType, class AController* InstigatedBy, AActor* DamageCauser);
 
+	/* Native listeners first, the dynamic delegate only when Blueprint bound to it */
+	void BroadcastHealthChanged(float HealthDelta, const class UDamageType* DamageType, class AController* InstigatedBy, AActor* DamageCauser);
+
 public:
 
 	float GetHealth() const;
 
+	/* For Blueprint, C++ listeners bind OnHealthChangedNative */
 	UPROPERTY(BlueprintAssignable, Category = "Events")
 	FOnHealthChangedSignature OnHealthChanged;
 
+	FOnHealthChangedNative OnHealthChangedNative;
+
 	UFUNCTION(BlueprintCallable, Category = "HealthComponent")
 	void Heal(float HealAmount);
 
+	/* Server, back to full health and alive again, for pawns that are reused after death */
+	void ResetHealth();
+
 	UFUNCTION(BlueprintCallable, BlueprintPure, Category = "HealthComponent")
 	static bool IsFriendly(AActor* ActorA, AActor* ActorB);
 };
+
+
+/* Listener for COOP.Health.DelegateBenchmark, one handler per delegate flavour */
+UCLASS(Transient)
+class UShooterHealthBenchmarkListener : public UObject
+{
+	GENERATED_BODY()
+
+public:
+
+	UFUNCTION()
+	void OnHealthChangedDynamic(UShooterHealthComponent* HealthComp, float Health, float HealthDelta, const class UDamageType* DamageType,
+		class AController* InstigatedBy, AActor* DamageCauser);
+
+	void OnHealthChangedNative(const FShooterHealthChange& Change);
+
+	/* Summed so the handlers can't be optimized away */
+	float HealthSum;
+};
@@ -0,0 +1,176 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Components/ActorComponent.h"
+#include "Chaos/ChaosEngineInterface.h"
+#include "ShooterHitboxHistoryComponent.generated.h"
+
+class USkeletalMeshComponent;
+
+
+/* A capsule between two bones, or a sphere around one bone when EndBoneName is empty */
+USTRUCT()
+struct FShooterHitbox
+{
+	GENERATED_BODY()
+
+public:
+
+	/* Bone the hitbox starts at. None follows the owner's root component. */
+	UPROPERTY(EditDefaultsOnly, Category = "Hitbox")
+	FName BoneName;
+
+	/* Bone the hitbox ends at. None makes this a sphere. */
+	UPROPERTY(EditDefaultsOnly, Category = "Hitbox")
+	FName EndBoneName;
+
+	/* Radius of the capsule/sphere. Zero on a root hitbox uses the owner's bounds. */
+	UPROPERTY(EditDefaultsOnly, Category = "Hitbox")
+	float Radius;
+
+	/* Surface reported for hits on this box, used for the headshot multiplier */
+	UPROPERTY(EditDefaultsOnly, Category = "Hitbox")
+	TEnumAsByte<EPhysicalSurface> SurfaceType;
+
+	FShooterHitbox()
+		: BoneName(NAME_None)
+		, EndBoneName(NAME_None)
+		, Radius(0.0f)
+		, SurfaceType(SurfaceType_Default)
+	{
+	}
+
+	FShooterHitbox(FName InBoneName, FName InEndBoneName, float InRadius, EPhysicalSurface InSurfaceType)
+		: BoneName(InBoneName)
+		, EndBoneName(InEndBoneName)
+		, Radius(InRadius)
+		, SurfaceType(InSurfaceType)
+	{
+	}
+};
+
+
+/* Result of a ray test against rewound hitboxes */
+struct FShooterRewindHit
+{
+	int32 HitboxIndex;
+
+	/* Entry point of the ray into the hitbox */
+	FVector ImpactPoint;
+
+	FVector ImpactNormal;
+
+	/* Distance from the ray start to ImpactPoint */
+	float Distance;
+};
+
+
+/**
+ * Keeps a short server-side history of the owner's hitboxes so shots can be validated against
+ * the pose the shooting client actually saw, instead of the current server pose.
+ */
+UCLASS( ClassGroup=(PROTOTYPE), meta=(BlueprintSpawnableComponent) )
+class PROTOTYPE_API UShooterHitboxHistoryComponent : public UActorComponent
+{
+	GENERATED_BODY()
+
+public:
+
+	UShooterHitboxHistoryComponent();
+
+	virtual void TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction) override;
+
+	/* Test a ray against the hitboxes as they were at Time (server world time). Returns the closest hit. */
+	bool RewindRayTest(float Time, const FVector& TraceStart, const FVector& TraceEnd, FShooterRewindHit& OutHit) const;
+
+	/* Build a hit result for a confirmed rewind hit, so it can go through the regular damage path */
+	FHitResult MakeHitResult(const FShooterRewindHit& RewindHit, const FVector& TraceStart, const FVector& TraceEnd) const;
+
+	/* Surface of the hitbox or physics body on BoneName, SurfaceType_Default if there is none */
+	EPhysicalSurface GetSurfaceForBone(FName BoneName) const;
+
+	const TArray<FShooterHitbox>& GetHitboxes() const
+	{
+		return Hitboxes;
+	}
+
+	/* Replace the hitbox layout, owners call this from their constructor */
+	void SetHitboxes(const TArray<FShooterHitbox>& NewHitboxes);
+
+	/* Evaluate the owner's pose at full rate until at least Time (server world time) */
+	void WakePose(float Time);
+
+	/* Forget all recorded frames, so a pawn that is reused elsewhere can't be hit where it used to be */
+	void ClearHistory();
+
+protected:
+
+	virtual void BeginPlay() override;
+
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+	/* Store the current hitbox positions as the newest frame */
+	void RecordFrame(float Time);
+
+	/* Give every physics asset body the surface of the closest hitbox at or above its bone */
+	void BuildBodySurfaces();
+
+	/* World space start/end of a hitbox right now */
+	void GetCurrentSegment(int32 HitboxIndex, FVector& OutStart, FVector& OutEnd) const;
+
+	/* Switch the skeletal mesh between full rate and COOP.ServerAnim.IdleInterval */
+	void SetPoseAwake(bool bAwake);
+
+	UPROPERTY(EditDefaultsOnly, Category = "Hitbox")
+	TArray<FShooterHitbox> Hitboxes;
+
+	/* Number of frames kept. Together with SampleInterval this bounds how far back we can rewind. */
+	UPROPERTY(EditDefaultsOnly, Category = "Hitbox", meta = (ClampMin = 2))
+	int32 MaxFrames;
+
+	/* Minimum time between two recorded frames */
+	UPROPERTY(EditDefaultsOnly, Category = "Hitbox", meta = (ClampMin = 0.0f))
+	float SampleInterval;
+
+	UPROPERTY(Transient)
+	USkeletalMeshComponent* SkeletalMesh;
+
+	/* Surface per physics asset body, so simple collision hits on any body still find their hitbox surface */
+	TMap<FName, TEnumAsByte<EPhysicalSurface>> BodySurfaces;
+
+	/* Bone indices resolved once on begin play, INDEX_NONE follows the root component */
+	TArray<int32> StartBoneIndices;
+
+	TArray<int32> EndBoneIndices;
+
+	/* Radius per hitbox after resolving bounds-based radii */
+	TArray<float> Radii;
+
+	/* Flat ring buffer of segment endpoints, MaxFrames * Hitboxes.Num() * 2, one contiguous block per frame */
+	TArray<FVector> SegmentHistory;
+
+	TArray<float> FrameTimes;
+
+	/* Bounding sphere of all hitboxes per frame (xyz center, w radius), used to reject rays early */
+	TArray<FVector4> FrameBounds;
+
+	/* Slot of the newest frame in the ring */
+	int32 NewestFrame;
+
+	int32 NumRecordedFrames;
+
+	/**
+	 * Dedicated servers only use poses to validate hits. Idle meshes evaluate at a reduced rate
+	 * (the capsule still moves exactly, only the limbs lag), nearby combat or an armed character wakes them up.
+	 */
+	bool bPoseSleepEnabled;
+
+	bool bPoseAwake;
+
+	float PoseAwakeUntil;
+
+	/* World time the mesh last evaluated its pose, a woken pose is advanced by the time it slept through */
+	float LastPoseTickTime;
+};
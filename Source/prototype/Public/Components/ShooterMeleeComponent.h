@@ -0,0 +1,77 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Components/ActorComponent.h"
+#include "ShooterMeleeComponent.generated.h"
+
+class USkeletalMeshComponent;
+class UDamageType;
+
+
+/**
+ * Server-side melee hit detection. During a hit window (see UShooterMeleeNotifyState) the blade or fist
+ * is swept as a capsule from where it was last frame to where it is now, and every actor it passes
+ * through takes point damage once per swing.
+ */
+UCLASS( ClassGroup=(PROTOTYPE), meta=(BlueprintSpawnableComponent) )
+class PROTOTYPE_API UShooterMeleeComponent : public UActorComponent
+{
+	GENERATED_BODY()
+
+public:
+
+	UShooterMeleeComponent();
+
+	/* Open a hit window. EndSocket None sweeps a sphere around StartSocket. */
+	void BeginSwing(USkeletalMeshComponent* TraceMesh, FName StartSocket, FName EndSocket, float Radius, float Damage, TSubclassOf<UDamageType> DamageType, AActor* DamageCauser);
+
+	/* Sweep from the previous to the current socket positions */
+	void TickSwing();
+
+	void EndSwing();
+
+	bool IsSwinging() const
+	{
+		return bSwinging;
+	}
+
+protected:
+
+	/* Segment between the swing sockets right now */
+	void GetSwingSegment(FVector& OutStart, FVector& OutEnd) const;
+
+	/* Sweep a capsule spanning the segment from its From to its To position, damaging new actors */
+	void SweepSegment(const FVector& FromStart, const FVector& FromEnd, const FVector& ToStart, const FVector& ToEnd);
+
+	/* Max distance a socket may move per sweep, longer frames are split into substeps */
+	UPROPERTY(EditDefaultsOnly, Category = "Melee", meta = (ClampMin = 1.0f))
+	float MaxSubstepDistance;
+
+	UPROPERTY(EditDefaultsOnly, Category = "Melee", meta = (ClampMin = 1))
+	int32 MaxSubsteps;
+
+	TWeakObjectPtr<USkeletalMeshComponent> SwingMesh;
+
+	FName SwingStartSocket;
+
+	FName SwingEndSocket;
+
+	float SwingRadius;
+
+	float SwingDamage;
+
+	TSubclassOf<UDamageType> SwingDamageType;
+
+	TWeakObjectPtr<AActor> SwingDamageCauser;
+
+	FVector PrevSwingStart;
+
+	FVector PrevSwingEnd;
+
+	bool bSwinging;
+
+	/* Actors this swing already hit, a swing rarely hits more than a few */
+	TArray<TWeakObjectPtr<AActor>, TInlineAllocator<8>> SwingHitActors;
+};
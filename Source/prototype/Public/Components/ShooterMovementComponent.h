@@ -6,13 +6,88 @@
 #include "GameFramework/CharacterMovementComponent.h"
 #include "ShooterMovementComponent.generated.h"
 
+class AShooterCharacter;
+class UShooterAttributeComponent;
+
+
+/* Saved move carrying the sprint and targeting state in the compressed flags, so speed changes are predicted and replayed */
+class FSavedMove_Shooter : public FSavedMove_Character
+{
+public:
+
+	typedef FSavedMove_Character Super;
+
+	virtual void Clear() override;
+
+	virtual uint8 GetCompressedFlags() const override;
+
+	virtual bool CanCombineWith(const FSavedMovePtr& NewMove, ACharacter* InCharacter, float MaxDelta) const override;
+
+	virtual void SetMoveFor(ACharacter* C, float InDeltaTime, FVector const& NewAccel, FNetworkPredictionData_Client_Character& ClientData) override;
+
+	virtual void PrepMoveFor(ACharacter* C) override;
+
+	uint8 bSavedWantsToSprint : 1;
+
+	uint8 bSavedWantsToTarget : 1;
+};
+
+
+class FNetworkPredictionData_Client_Shooter : public FNetworkPredictionData_Client_Character
+{
+public:
+
+	typedef FNetworkPredictionData_Client_Character Super;
+
+	FNetworkPredictionData_Client_Shooter(const UCharacterMovementComponent& ClientMovement);
+
+	virtual FSavedMovePtr AllocateNewMove() override;
+};
+
+
 /**
- * 
+ * Character movement with sprint and targeting speed modifiers. Both states travel with every move
+ * (FLAG_Custom_0 and FLAG_Custom_1) instead of separate RPCs, jumps use the built-in jump flag.
  */
 UCLASS()
 class PROTOTYPE_API UShooterMovementComponent : public UCharacterMovementComponent
 {
 	GENERATED_BODY()
-	
+
+	friend class FSavedMove_Shooter;
+
+public:
+
+	UShooterMovementComponent();
+
 	virtual float GetMaxSpeed() const override;
+
+	/* Caches the shooter owner and its attributes, GetMaxSpeed runs many times per move */
+	virtual void SetUpdatedComponent(USceneComponent* NewUpdatedComponent) override;
+
+	virtual void UpdateFromCompressedFlags(uint8 Flags) override;
+
+	virtual FNetworkPredictionData_Client* GetPredictionData_Client() const override;
+
+	virtual bool ClientUpdatePositionAfterServerUpdate() override;
+
+	void SetWantsToSprint(bool bNewWantsToSprint);
+
+	void SetWantsToTarget(bool bNewWantsToTarget);
+
+	/* Sprinting as the movement sees it, from the predicted flags and the current velocity */
+	bool IsSprinting() const;
+
+protected:
+
+	/* Predicted input state, set locally and carried by the saved moves */
+	uint8 bWantsToSprint : 1;
+
+	uint8 bWantsToTarget : 1;
+
+	UPROPERTY(Transient)
+	AShooterCharacter* ShooterOwner;
+
+	UPROPERTY(Transient)
+	UShooterAttributeComponent* OwnerAttributes;
 };
@@ -16,6 +16,11 @@ protected:
 	// Sets default values for this actor's properties
 	AShooterUsableActor();
 
+	/* Registers with the world's usable index, so players only trace for focus when one is near */
+	virtual void BeginPlay() override;
+
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
 	UPROPERTY(VisibleAnywhere, Category = "Mesh")
 	UStaticMeshComponent* MeshComp;
 
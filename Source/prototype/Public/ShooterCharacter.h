@@ -4,6 +4,9 @@
 
 #include "CoreMinimal.h"
 #include "GameFramework/Character.h"
+#include "WorldCollision.h"
+#include "Subsystems/ShooterSignificanceSubsystem.h"
+#include "Subsystems/ShooterPawnRecyclerSubsystem.h"
 #include "ShooterCharacter.generated.h"
 
 
@@ -41,11 +44,16 @@ class USpringArmComponent;
 class UPawnNoiseEmitterComponent;
 class AShooterWeapon;
 class UShooterHealthComponent;
+struct FShooterHealthChange;
+class UShooterHitboxHistoryComponent;
+class UShooterMeleeComponent;
+class UShooterFootIKComponent;
+class UShooterAttributeComponent;
 class AShooterUsableActor;
 class USoundCue;
 
 UCLASS()
-class PROTOTYPE_API AShooterCharacter : public ACharacter
+class PROTOTYPE_API AShooterCharacter : public ACharacter, public IShooterRecyclable
 {
 	GENERATED_BODY()
 
@@ -64,6 +72,9 @@ class PROTOTYPE_API AShooterCharacter : public ACharacter
 	/* Stop playing all montages */
 	void StopAllAnimMontages();
 
+	/* Montages drive melee hit windows, a dedicated server wakes the poses around us before playing one */
+	virtual float PlayAnimMontage(class UAnimMontage* AnimMontage, float InPlayRate = 1.f, FName StartSectionName = NAME_None) override;
+
 	FRotator ControllerRotationBeforeFreelook;
 
 	float LastNoiseLoudness;
@@ -94,6 +105,12 @@ public:
 	UFUNCTION(BlueprintCallable, Category = "Movement")
 	bool IsSprinting() const;
 
+	/* How relevant this character currently is to the players, cosmetics are scaled down with it */
+	EShooterSignificance GetSignificance() const
+	{
+		return Significance;
+	}
+
 	UFUNCTION(BlueprintCallable, Category = "Weapon")
 	bool IsFiring() const;
 
@@ -115,6 +132,9 @@ public:
 	float GetTargetingSpeedModifier() const;
 	float GetSprintingSpeedModifier() const;
 
+	/* Server side, takes over the sprint and targeting state carried by the owning client's moves */
+	void ApplyMoveFlags(bool NewWantsToRun, bool NewTargeting);
+
 	/* Retrieve Pitch/Yaw from current camera */
 	UFUNCTION(BlueprintCallable, Category = "Targeting")
 	FRotator GetAimOffsets() const;
@@ -149,14 +169,9 @@ public:
 	void EndCrouch();
 
 
+	/* Sprint state reaches the server with the movement, see UShooterMovementComponent */
 	void SetSprinting(bool NewSprinting);
 
-	/* Server side call to update actual sprint state */
-	UFUNCTION(Server, Reliable, WithValidation)
-	void ServerSetSprinting(bool NewSprinting);
-	void ServerSetSprinting_Implementation(bool NewSprinting);
-	bool ServerSetSprinting_Validate(bool NewSprinting);
-
 	// input
 	void BeginSprint();
 	void EndSprint();
@@ -164,26 +179,20 @@ public:
 
 	void SetIsJumping(bool NewJumping);
 
-	UFUNCTION(Reliable, Server, WithValidation)
-	void ServerSetIsJumping(bool NewJumping);
-	void ServerSetIsJumping_Implementation(bool NewJumping);
-	bool ServerSetIsJumping_Validate(bool NewJumping);
-
 	void BeginJump();
 
+	/* Runs wherever the jump is performed, including the server replaying the client's jump flag */
+	virtual void OnJumped_Implementation() override;
+
 	virtual void OnMovementModeChanged(EMovementMode PrevMovementMode, uint8 PreviousCustomMode = 0) override;
 
 	/************************************************************************/
 	/* Targeting                                                            */
 	/************************************************************************/
 
+	/* Targeting state reaches the server with the movement, see UShooterMovementComponent */
 	void SetTargeting(bool NewTargeting);
 
-	UFUNCTION(Server, Reliable, WithValidation)
-	void ServerSetTargeting(bool NewTargeting);
-	void ServerSetTargeting_Implementation(bool NewTargeting);
-	bool ServerSetTargeting_Validate(bool NewTargeting);
-
 	// input
 	void BeginTarget();
 	void EndTarget();
@@ -207,11 +216,36 @@ public:
 	UPROPERTY(EditDefaultsOnly, Category = "ObjectInteraction")
 	float MaxUseDistance;
 
-	/* True only in first frame when focused on a new usable actor. */
-	bool bHasNewFocus;
+	/* Seconds between focus checks of the local player */
+	UPROPERTY(EditDefaultsOnly, Category = "ObjectInteraction", meta = (ClampMin = 0.0f))
+	float FocusCheckInterval;
+
+	/* Trace for the usable in view, only when the usable index has one within MaxUseDistance */
+	void UpdateFocus();
+
+	void OnFocusTraceCompleted(const FTraceHandle& Handle, FTraceDatum& Data);
 
+	void SetFocusedUsable(AShooterUsableActor* Usable);
+
+	UPROPERTY(Transient)
 	AShooterUsableActor* FocusedUsableActor;
 
+	float LastFocusCheckTime;
+
+	bool bFocusTracePending;
+
+	FTraceDelegate FocusTraceDelegate;
+
+	/* Server keeps the poses around an armed character at full rate, so the history it may rewind into was recorded awake */
+	void WakeNearbyPoses();
+
+	float LastPoseWakeTime;
+
+	/* Scale tick and animation rate with distance to the players */
+	void OnSignificanceChanged(EShooterSignificance NewSignificance);
+
+	EShooterSignificance Significance;
+
 protected:
 	UPROPERTY(EditDefaultsOnly, Category = "Movement")
 	float SprintingSpeedModifier;
@@ -241,10 +275,26 @@ protected:
 	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Components")
 	UShooterHealthComponent* HealthComp;
 
+	/* Recent hitbox poses for server-side lag compensation */
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Components")
+	UShooterHitboxHistoryComponent* HitboxHistoryComp;
+
+	/* Hit detection for punches and melee weapons, driven by melee hit window notifies */
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Components")
+	UShooterMeleeComponent* MeleeComp;
+
 	/* Tracks noise data used by the pawn sensing component */
 	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Components")
 	UPawnNoiseEmitterComponent* NoiseEmitterComp;
 
+	/* Ground traces for foot placement, read by the anim instance */
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Components")
+	UShooterFootIKComponent* FootIKComp;
+
+	/* Move speed, damage and fire rate modifiers from powerups */
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Components")
+	UShooterAttributeComponent* AttributeComp;
+
 	UPROPERTY(EditDefaultsOnly, Category = "Player")
 	float ZoomedFOV;
 
@@ -254,12 +304,31 @@ protected:
 	// Default FOV set during begin play
 	float DefaultFOV;
 
-	UFUNCTION()
-	void OnHealthChanged(UShooterHealthComponent* OwningHealthComp, float Health, float HealthDelta, const UDamageType* DamageType, AController* InstigatedBy, AActor* DamageCauser);
+	void OnHealthChanged(const FShooterHealthChange& Change);
 
 	UPROPERTY(Replicated, BlueprintReadOnly, Category = "Player")
 	bool bDied;
 
+	/* Death was applied on this machine, bDied may replicate before or after the health that caused it */
+	bool bDeathApplied;
+
+	/* Seconds the body stays after death before it is destroyed or stored for reuse */
+	UPROPERTY(EditDefaultsOnly, Category = "Player")
+	float CorpseLifeSpan;
+
+	/* Undo the death state, runs wherever health comes back after a reuse */
+	void RestoreFromDeath();
+
+public:
+
+	/************************************************************************/
+	/* IShooterRecyclable                                                   */
+	/************************************************************************/
+
+	virtual void StoreCorpse() override;
+
+	virtual void ResetForReuse(const FTransform& SpawnTransform) override;
+
 protected:
 
 	//UPROPERTY(Replicated)
@@ -342,6 +411,21 @@ public:
 	UFUNCTION(BlueprintCallable, Category = "Weapon")
 	AShooterWeapon* GetCurrentWeapon() const;
 
+	UShooterMeleeComponent* GetMeleeComp() const
+	{
+		return MeleeComp;
+	}
+
+	UShooterFootIKComponent* GetFootIKComp() const
+	{
+		return FootIKComp;
+	}
+
+	UShooterAttributeComponent* GetAttributeComp() const
+	{
+		return AttributeComp;
+	}
+
 	void SetCurrentWeapon(AShooterWeapon* newWeapon, AShooterWeapon* LastWeapon = nullptr);
 
 
@@ -378,6 +462,12 @@ public:
 
 	void Punch();
 
+	/* Play the punch on the server, where its hit window deals the damage */
+	UFUNCTION(Server, Reliable, WithValidation)
+	void ServerPunch();
+	void ServerPunch_Implementation();
+	bool ServerPunch_Validate();
+
 };
 
 
@@ -8,6 +8,7 @@
 
 
 class UShooterHealthComponent;
+struct FShooterHealthChange;
 class UStaticMeshComponent;
 class URadialForceComponent;
 class UParticleSystem;
@@ -33,9 +34,7 @@ protected:
 	UPROPERTY(VisibleAnywhere, Category = "Components")
 	URadialForceComponent* RadialForceComp;
 
-	UFUNCTION()
-	void OnHealthChanged(UShooterHealthComponent* OwningHealthComp, float Health, float HealthDelta, const class UDamageType* DamageType,
-		class AController* InstigatedBy, AActor* DamageCauser);
+	void OnHealthChanged(const FShooterHealthChange& Change);
 
 	UPROPERTY(ReplicatedUsing = OnRep_Exploded)
 	bool bExploded;
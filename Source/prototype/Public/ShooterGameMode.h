@@ -36,12 +36,34 @@ protected:
 	UPROPERTY(EditDefaultsOnly, Category = "GameMode")
 	float TimeBetweenWaves;
 
+	/* Bot the waves spawn through SpawnBot, so dead bots are reused. Leave empty to spawn from Blueprint in SpawnNewBot. */
+	UPROPERTY(EditDefaultsOnly, Category = "GameMode")
+	TSubclassOf<APawn> WaveBotClass;
+
+	/* Actors with this tag mark where wave bots enter the level */
+	UPROPERTY(EditDefaultsOnly, Category = "GameMode")
+	FName BotSpawnTag;
+
+	/* Wave bots spawn on a random navigable point within this distance of a spawn marker */
+	UPROPERTY(EditDefaultsOnly, Category = "GameMode", meta = (ClampMin = 0.0f))
+	float BotSpawnRadius;
+
+	UPROPERTY(Transient)
+	TArray<AActor*> BotSpawnPoints;
+
 protected:
 
-	// Hook for BP to spawn a single bot
+	// Hook for BP to spawn a single bot, only used when there is no WaveBotClass or spawn marker
 	UFUNCTION(BlueprintImplementableEvent, Category = "GameMode")
 	void SpawnNewBot();
 
+	/* Spawn a bot, reusing a dead one of the same class when the recycler has it */
+	UFUNCTION(BlueprintCallable, Category = "GameMode")
+	APawn* SpawnBot(TSubclassOf<APawn> BotClass, const FTransform& SpawnTransform);
+
+	/* Spawn one WaveBotClass bot at a random spawn marker. False when there is nothing to spawn or nowhere to spawn it. */
+	bool SpawnWaveBot();
+
 	void SpawnBotTimerElapsed();
 
 	// Start Spawning Bots
@@ -71,6 +93,9 @@ protected:
 	*/
 	virtual void SetPlayerDefaults(APawn* PlayerPawn) override;
 
+	/* Respawns reuse a dead pawn of the default class when the recycler has it */
+	virtual APawn* SpawnDefaultPawnAtTransform_Implementation(AController* NewPlayer, const FTransform& SpawnTransform) override;
+
 public:
 
 	AShooterGameMode();
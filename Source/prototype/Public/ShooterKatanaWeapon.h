@@ -18,6 +18,10 @@ protected:
 
 	AShooterKatanaWeapon();
 
-	virtual void Fire() override;
+	/* Swings instead of shooting, damage comes from the melee hit window in AttackAnim */
+	virtual void FireShot(const FVector& Origin, const FRotator& AimRotation, int32 ShotIndex, float Timestamp) override;
+
+	UPROPERTY(EditDefaultsOnly, Category = "Animation")
+	UAnimMontage* AttackAnim;
 
 };
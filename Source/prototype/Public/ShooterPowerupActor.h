@@ -4,6 +4,7 @@
 
 #include "CoreMinimal.h"
 #include "GameFramework/Actor.h"
+#include "Components/ShooterAttributeComponent.h"
 #include "ShooterPowerupActor.generated.h"
 
 UCLASS()
@@ -43,6 +44,18 @@ protected:
 	UFUNCTION(BlueprintImplementableEvent, Category = "Powerups")
 	void OnPowerupStateChanged(bool bNewIsActive);
 
+	/* Attribute modifiers held on whoever activated us until we expire, e.g. MoveSpeed Multiply 2 for super speed */
+	UPROPERTY(EditDefaultsOnly, Category = "Powerups")
+	TArray<FShooterAttributeModifier> Modifiers;
+
+	TWeakObjectPtr<UShooterAttributeComponent> ModifiedAttributes;
+
+	TArray<int32> ModifierHandles;
+
+	void RemoveModifiers();
+
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
 public:	
 
 	void ActivatePowerup(AActor* ActiveFor);
@@ -4,23 +4,50 @@
 
 #include "CoreMinimal.h"
 #include "ShooterWeapon.h"
+#include "Subsystems/ShooterProjectileSubsystem.h"
 #include "ShooterProjectileWeapon.generated.h"
 
 /**
- * 
+ * Fires projectiles simulated by UShooterProjectileSubsystem instead of spawning an actor per shot.
+ * Each projectile replicates once as a spawn and once as a detonation, clients simulate the flight in between.
  */
 UCLASS()
 class PROTOTYPE_API AShooterProjectileWeapon : public AShooterWeapon
 {
 	GENERATED_BODY()
 
+public:
+
+	/* Server detonated one of our projectiles */
+	UFUNCTION(NetMulticast, Reliable)
+	void MulticastDetonateProjectile(int32 ShotId, FVector_NetQuantize Location);
+
 protected:
 
 	AShooterProjectileWeapon();
 
-	virtual void Fire() override;
+	virtual void BeginPlay() override;
+
+	virtual void FireShot(const FVector& Origin, const FRotator& AimRotation, int32 ShotIndex, float Timestamp) override;
+
+	/* Server fired a projectile, everyone but the shooter starts a copy of it */
+	UFUNCTION(NetMulticast, Unreliable)
+	void MulticastSpawnProjectile(const FShooterProjectileSpawn& Spawn);
+
+	UShooterProjectileSubsystem* GetProjectileSubsystem() const;
 
 	UPROPERTY(EditDefaultsOnly, Category = "ProjectileWeapon")
-	TSubclassOf<AActor> ProjectileClass;
+	FShooterProjectileParams ProjectileParams;
+
+	/* Longest flight time a late spawn is fast-forwarded by, older ones start from there */
+	UPROPERTY(EditDefaultsOnly, Category = "ProjectileWeapon", meta = (ClampMin = 0.0f))
+	float MaxSpawnCatchUp;
+
+	/* Index of ProjectileParams in the subsystem's type table */
+	int32 ProjectileType;
+
+	/* Number of the next projectile we fire. Counts every spawn on the server and on the shooting client,
+	   remote clients take the server's from the spawn event. */
+	int32 NextShotId;
 	
 };
@@ -0,0 +1,35 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "ShooterWeapon.h"
+#include "ShooterShotgunWeapon.generated.h"
+
+/**
+ * Fires PelletCount hitscan pellets per shot within BulletSpread. The pellets are traced as one group,
+ * damage is merged into one hit per victim and impacts landing close together share one effect.
+ */
+UCLASS()
+class PROTOTYPE_API AShooterShotgunWeapon : public AShooterWeapon
+{
+	GENERATED_BODY()
+
+protected:
+
+	AShooterShotgunWeapon();
+
+	virtual void FireShot(const FVector& Origin, const FRotator& AimRotation, int32 ShotIndex, float Timestamp) override;
+
+	virtual void OnHitScanGroupCompleted(TArrayView<const FShooterHitScanRequest> Requests, TArrayView<const FHitResult> Hits) override;
+
+	/* Spread direction of every pellet of a shot, computed four pellets at a time */
+	void SamplePelletDirections(const FVector& AimDirection, int32 ShotIndex, TArrayView<FVector> OutDirections) const;
+
+	UPROPERTY(EditDefaultsOnly, Category = "ShotgunWeapon", meta = (ClampMin = 1, ClampMax = 16))
+	int32 PelletCount;
+
+	/* Impacts on the same surface type closer than this to each other play one effect */
+	UPROPERTY(EditDefaultsOnly, Category = "ShotgunWeapon", meta = (ClampMin = 0.0f))
+	float ImpactClusterRadius;
+};
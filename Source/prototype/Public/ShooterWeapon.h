@@ -5,6 +5,7 @@
 #include "CoreMinimal.h"
 #include "GameFramework/Actor.h"
 #include "ShooterCharacter.h"
+#include "Engine/NetSerialization.h"
 #include "ShooterWeapon.generated.h"
 
 
@@ -28,25 +29,157 @@ enum class EWeaponType
 
 
 class USkeletalMeshComponent;
+class UStaticMeshComponent;
 class UDamageType;
 class UParticleSystem;
 class AShooterCharacter;
 class AShooterWeaponPickup;
 class USoundCue;
+struct FShooterHitScanRequest;
 
 
+/* Aim a client reported for one shot of its burst, compressed the way it was sent */
+struct FShooterBurstAim
+{
+	int32 ShotIndex;
+
+	uint16 Pitch;
+
+	uint16 Yaw;
+};
+
+
+/* One hitscan shot as replayed by remote clients */
 USTRUCT()
-struct FHitScanTrace
+struct FShooterShotRecord
 {
 	GENERATED_BODY()
 
 public:
 
+	/* Rounded to whole units, so deltas between endpoints are exact */
+	UPROPERTY()
+	FVector TraceTo;
+
 	UPROPERTY()
 	TEnumAsByte<EPhysicalSurface> SurfaceType;
 
 	UPROPERTY()
-	FVector_NetQuantize TraceTo;
+	bool bBlockingHit;
+
+	/* Wraps around, only used to replay shots in firing order and skip ones already played */
+	UPROPERTY()
+	uint8 ShotCounter;
+
+	FShooterShotRecord()
+		: TraceTo(ForceInitToZero)
+		, SurfaceType(SurfaceType_Default)
+		, bBlockingHit(false)
+		, ShotCounter(0)
+	{
+	}
+};
+
+
+/**
+ * Ring of the last few shots of a weapon. Each connection is only sent the shots fired since the
+ * counter it last acknowledged: the newest counter, how many shots follow, and per shot its hit
+ * flag and surface plus the endpoint as a delta from the previous endpoint in the same update.
+ * Remote clients replay every shot instead of only the ones current when the weapon replicated.
+ */
+USTRUCT()
+struct FShooterShotHistory
+{
+	GENERATED_BODY()
+
+public:
+
+	/* Shots kept for connections that fell behind, older ones are recycled */
+	enum { Capacity = 8 };
+
+	FShooterShotHistory()
+		: OwnerWeapon(nullptr)
+		, NextSlot(0)
+		, NextShotCounter(0)
+		, LastPlayedShotCounter(0)
+		, bHasPlayedShot(false)
+	{
+	}
+
+	/* Server: record a confirmed shot */
+	void AddShot(const FVector& TraceTo, EPhysicalSurface SurfaceType, bool bBlockingHit);
+
+	bool NetDeltaSerialize(FNetDeltaSerializeInfo& DeltaParms);
+
+	UPROPERTY(NotReplicated)
+	class AShooterWeapon* OwnerWeapon;
+
+private:
+
+	/* Client: replay the received shots the client hasn't played yet, they arrive oldest first */
+	void PlayNewShots(TArrayView<const FShooterShotRecord> NewShots);
+
+	/* Server only, clients replay what they receive and keep nothing */
+	TArray<FShooterShotRecord> Shots;
+
+	int32 NextSlot;
+
+	uint8 NextShotCounter;
+
+	uint8 LastPlayedShotCounter;
+
+	bool bHasPlayedShot;
+};
+
+template<>
+struct TStructOpsTypeTraits<FShooterShotHistory> : public TStructOpsTypeTraitsBase2<FShooterShotHistory>
+{
+	enum
+	{
+		WithNetDeltaSerializer = true,
+	};
+};
+
+
+/* Authoritative ammo of a weapon, sent to its owner along with the last predicted change the server has applied */
+USTRUCT()
+struct FShooterAmmoState
+{
+	GENERATED_BODY()
+
+public:
+
+	UPROPERTY()
+	int32 Ammo;
+
+	UPROPERTY()
+	int32 AmmoInClip;
+
+	UPROPERTY()
+	int32 AckedSequence;
+
+	FShooterAmmoState()
+		: Ammo(0)
+		, AmmoInClip(0)
+		, AckedSequence(INDEX_NONE)
+	{
+	}
+};
+
+
+enum class EShooterAmmoChange : uint8
+{
+	Shot,
+	Reload,
+};
+
+
+/* Ammo change the owning client applied ahead of the server */
+struct FShooterPendingAmmoChange
+{
+	int32 Sequence;
+
+	EShooterAmmoChange Type;
 };
 
 
@@ -97,9 +230,17 @@ protected:
 	UFUNCTION()
 	void OnRep_MyPawn();
 
+	/* Pawn our tick currently waits on, added while equipped */
+	TWeakObjectPtr<AShooterCharacter> TickPrerequisitePawn;
+
+	void SetTickPrerequisitePawn(AShooterCharacter* NewPawn);
+
 	/** detaches weapon mesh from pawn */
 	void DetachMeshFromPawn();
 
+	/* Holstered weapons show the static proxy and stop the skeletal mesh from ticking and skinning */
+	void SetHolstered(bool bHolstered);
+
 	virtual void OnEquipFinished();
 
 	virtual void OnUnEquipFinished();
@@ -152,9 +293,16 @@ protected:
 
 	virtual void BeginPlay() override;
 
+	/* Drives the fire cadence, only enabled during a burst */
+	virtual void Tick(float DeltaSeconds) override;
+
 	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Components")
 	USkeletalMeshComponent* MeshComp;
 
+	/* Static stand-in shown while the weapon sits in its storage slot, set its mesh to a static version of the weapon */
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Components")
+	UStaticMeshComponent* HolsterMeshComp;
+
 	void PlayFireEffects(FVector TraceEnd);
 
 	void PlayImpactEffects(EPhysicalSurface SurfaceType, FVector ImpactPoint);
@@ -180,19 +328,67 @@ protected:
 	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Weapon")
 	UParticleSystem* TracerEffect;
 
+	/* Components created in the FX pool per effect when the weapon spawns */
+	UPROPERTY(EditDefaultsOnly, Category = "Weapon", meta = (ClampMin = 0))
+	int32 FXPrewarmCount;
+
 	UPROPERTY(EditDefaultsOnly, Category = "Weapon")
 	TSubclassOf<UCameraShakeBase> FireCamShake;
 
 	UPROPERTY(EditDefaultsOnly, Category = "Weapon")
 	float BaseDamage;
 
-	virtual void Fire();
+	/* Melee weapons swing without ammo */
+	UPROPERTY(EditDefaultsOnly, Category = "Weapon")
+	bool bUsesAmmo;
 
-	UFUNCTION(Server, Reliable, WithValidation)
-	void ServerFire();
+	/* Max distance of a hitscan shot */
+	UPROPERTY(EditDefaultsOnly, Category = "Weapon")
+	float WeaponRange;
+
+	/* Fire every shot of the local burst that came due since the last tick */
+	void FireOwedShots();
+
+	/* Fire a single shot from Origin along AimRotation. Runs on the shooting client and on the server for simulated bursts. */
+	virtual void FireShot(const FVector& Origin, const FRotator& AimRotation, int32 ShotIndex, float Timestamp);
+
+	/**
+	 * Spread direction of shot ShotIndex (and pellet SubIndex) of the burst seeded with Seed.
+	 * Counter based, so client and server get the same direction in any order and skipped shots don't shift later ones.
+	 */
+	static FVector GetSpreadDirection(const FVector& AimDirection, float HalfAngleRad, int32 Seed, int32 ShotIndex, int32 SubIndex = 0);
+
+	/* The two uniform [0, 1] numbers GetSpreadDirection builds its direction from */
+	static void GetSpreadUniforms(int32 Seed, int32 ShotIndex, int32 SubIndex, float& OutU, float& OutV);
+
+	/* Send a shot to the hitscan subsystem */
+	void QueueHitScan(const FShooterHitScanRequest& Request);
+
+	/* Send all pellets of a shot to the hitscan subsystem as one group */
+	void QueueHitScanGroup(TArrayView<const FShooterHitScanRequest> Requests);
+
+	/* Server, keep the poses of everything the shot may hit evaluated at full rate */
+	void WakeTargetPoses(const FVector& Start, const FVector& End) const;
+
+	/* Apply damage and effects of a resolved hitscan shot. Hit is empty when nothing was struck. */
+	virtual void ProcessInstantHit(const FShooterHitScanRequest& Request, const FHitResult& WorldHit);
+
+	/* Server judging the shots of a remote shooter against its targets rewound to the shot time */
+	bool IsLagCompensated() const;
+
+	/* Replace a world hit with the closest hit against targets rewound to the shot time */
+	FHitResult ResolveLagCompensatedHit(const FShooterHitScanRequest& Request, const FHitResult& WorldHit) const;
+
+	/* Surface type of a hit, preferring the hitbox layout of the victim over its physical material */
+	EPhysicalSurface DetermineHitSurface(const FHitResult& Hit) const;
 
-	FTimerHandle TimerHandle_TimerBetweenShots;
+	/* Current time on the server's clock, as estimated on this machine */
+	float GetServerWorldTime() const;
 
+	/* Latch TimeBetweenShots from ShotsPerMinute and the owner's fire rate modifier, done per burst on both ends */
+	void UpdateTimeBetweenShots();
+
+	/* Local time of the last shot, exact rather than the frame it was fired in */
 	float LastFireTime;
 
 	// Bullet Spread in Degrees
@@ -202,11 +398,79 @@ protected:
 	// Derived from RateOfFire
 	float TimeBetweenShots;
 
-	UPROPERTY(ReplicatedUsing = OnRep_HitScanTrace)
-	FHitScanTrace HitScanTrace;
+	/* Confirmed shots for remote clients, the owner plays its own shots when they resolve */
+	UPROPERTY(Replicated)
+	FShooterShotHistory ShotHistory;
 
-	UFUNCTION()
-	void OnRep_HitScanTrace();
+	/************************************************************************/
+	/* Burst protocol                                                       */
+	/************************************************************************/
+
+	/* Client started a burst. The server fires the burst itself at TimeBetweenShots from Timestamp. */
+	UFUNCTION(Server, Reliable, WithValidation)
+	void ServerStartBurst(float Timestamp, int32 Seed, int32 FirstSequence);
+
+	/* Client stopped a burst after firing ShotCount shots, the server catches up to that count and stops */
+	UFUNCTION(Server, Reliable, WithValidation)
+	void ServerStopBurst(int32 ShotCount);
+
+	/* Client aim at ShotIndex as compressed pitch/yaw. Only sent when the aim changed, losing one is harmless. */
+	UFUNCTION(Server, Unreliable, WithValidation)
+	void ServerUpdateBurstAim(uint16 ShotIndex, uint16 AimPitch, uint16 AimYaw);
+
+	/* Fire every shot the server owes for the current simulated burst */
+	void SimulateBurstShots();
+
+	/* Fire one shot of the simulated burst on the server */
+	void SimulateBurstShot(int32 ShotIndex);
+
+	void EndSimulatedBurst();
+
+	/* Local client: push the aim of the shot we just fired when it differs from what the server has */
+	void SendBurstAim(int32 ShotIndex, const FRotator& AimRotation);
+
+	/* Seed of the current burst, shared by client and server */
+	int32 BurstSeed;
+
+	/* Ammo sequence number of the first shot of the current burst, shot N uses BurstSequence + N */
+	int32 BurstSequence;
+
+	/* Server world time of the first shot of the current burst */
+	float BurstStartTime;
+
+	/* Server only: local time the simulated cadence started at */
+	float BurstSimStartTime;
+
+	/* Local time the first shot of the local burst is due */
+	float BurstLocalStartTime;
+
+	/* View at the previous tick, shots that fall between two ticks interpolate from it */
+	FVector LastAimLocation;
+
+	FRotator LastAimRotation;
+
+	float LastAimTime;
+
+	/* Shots fired so far in the current burst */
+	int32 BurstShotCount;
+
+	bool bBurstActive;
+
+	/* Server: the active burst is a client's, simulated from its burst messages */
+	bool bSimulatedBurst;
+
+	/* Local client: last aim sent to the server */
+	uint16 BurstAimPitch;
+
+	uint16 BurstAimYaw;
+
+	bool bHasBurstAim;
+
+	/* Server: reported aims by ascending shot index. Shot N uses the newest aim at or before N. */
+	TArray<FShooterBurstAim> BurstAims;
+
+	/* Aim for ShotIndex from BurstAims, false when the client hasn't reported one yet */
+	bool GetBurstAim(int32 ShotIndex, FRotator& OutAimRotation) const;
 
 public:	
 
@@ -217,8 +481,20 @@ public:
 
 	bool CanFire() const;
 
+	/* Called by the hitscan subsystem once the batched trace for a shot has completed */
+	void OnHitScanTraceCompleted(const FShooterHitScanRequest& Request, const FHitResult& Hit);
+
+	/* Called by the hitscan subsystem once every trace of a group has completed, Hits[i] belongs to Requests[i] */
+	virtual void OnHitScanGroupCompleted(TArrayView<const FShooterHitScanRequest> Requests, TArrayView<const FHitResult> Hits);
+
+	/* Play tracer and impact of a shot received through the shot history */
+	void PlayReplicatedShot(const FShooterShotRecord& Shot);
+
 	EWeaponState GetCurrentState() const;
 
+	/* Damage modifier of the owner's attributes, 1 without an owner */
+	float GetDamageMultiplier() const;
+
 	bool bPendingPunch;
 
 private:
@@ -241,9 +517,21 @@ private:
 	UFUNCTION()
 	void OnRep_BurstCounter();
 
+	/* Played per shot, unless the weapon has a fire loop */
 	UPROPERTY(EditDefaultsOnly, Category = "Sounds")
 	USoundCue* FireSound;
 
+	/* Looping sound held for a whole burst of automatic fire */
+	UPROPERTY(EditDefaultsOnly, Category = "Sounds")
+	USoundCue* FireLoopSound;
+
+	/* Played when a looping burst ends */
+	UPROPERTY(EditDefaultsOnly, Category = "Sounds")
+	USoundCue* FireFinishSound;
+
+	UPROPERTY(Transient)
+	UAudioComponent* FireLoopAC;
+
 	UPROPERTY(EditDefaultsOnly, Category = "Sounds")
 	USoundCue* EquipSound;
 
@@ -277,7 +565,8 @@ protected:
 
 	FVector GetMuzzleDirection() const;
 
-	UAudioComponent* PlayWeaponSound(USoundCue* SoundToPlay);
+	/* Play a sound from the world's weapon audio pool, bLooping sounds are held until stopped by the caller */
+	UAudioComponent* PlayWeaponSound(USoundCue* SoundToPlay, bool bLooping = false);
 
 	float PlayWeaponAnimation(UAnimMontage* Animation, float InPlayRate = 1.f, FName StartSectionName = NAME_None);
 
@@ -311,12 +600,41 @@ protected:
 
 	void UseAmmo();
 
-	UPROPERTY(Transient, Replicated)
+	/* Ammo on this machine. Predicted on the owning client, authoritative on the server. */
+	UPROPERTY(Transient)
 	int32 CurrentAmmo;
 
-	UPROPERTY(Transient, Replicated)
+	UPROPERTY(Transient)
 	int32 CurrentAmmoInClip;
 
+	UPROPERTY(Transient, ReplicatedUsing = OnRep_AmmoState)
+	FShooterAmmoState AmmoState;
+
+	/* Owning client: roll back to the server's ammo and replay the changes it hasn't applied yet */
+	UFUNCTION()
+	void OnRep_AmmoState();
+
+	/* Server: publish the current ammo to the owner, acknowledging predicted changes up to AckedSequence */
+	void UpdateAmmoState(int32 AckedSequence = INDEX_NONE);
+
+	/* Owning client: apply an ammo change now and keep it until the server acknowledges Sequence */
+	void PredictAmmoChange(EShooterAmmoChange Type, int32 Sequence);
+
+	/* Apply a change to the local ammo counts, shared by the server, prediction and replay */
+	void ApplyAmmoChange(EShooterAmmoChange Type);
+
+	/* Oldest first */
+	TArray<FShooterPendingAmmoChange> PendingAmmoChanges;
+
+	/* Sequence number of the last ammo change this client predicted */
+	int32 AmmoSequence;
+
+	/* Sequence number of the reload in progress */
+	int32 ReloadSequence;
+
+	/* Out of ammo while firing, stop and reload if we can */
+	void HandleOutOfAmmo();
+
 	/* Weapon ammo on spawn */
 	UPROPERTY(EditDefaultsOnly)
 	int32 StartAmmo;
@@ -348,7 +666,7 @@ protected:
 	void OnRep_Reload();
 
 	UFUNCTION(Server, Reliable, WithValidation)
-	void ServerStartReload();
+	void ServerStartReload(int32 Sequence);
 
 	UFUNCTION(Server, Reliable, WithValidation)
 	void ServerStopReload();
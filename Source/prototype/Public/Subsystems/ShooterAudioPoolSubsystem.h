@@ -0,0 +1,80 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "ShooterAudioPoolSubsystem.generated.h"
+
+class UAudioComponent;
+class USoundBase;
+class USceneComponent;
+
+
+/* A pooled audio component that is currently playing */
+USTRUCT()
+struct FShooterAudioVoice
+{
+	GENERATED_BODY()
+
+public:
+
+	UPROPERTY(Transient)
+	UAudioComponent* Component;
+
+	/* Actor the voice counts against, usually the weapon */
+	TWeakObjectPtr<const AActor> VoiceOwner;
+
+	/* Held by its owner (fire loops) and never stolen, the owner stops it */
+	bool bPersistent;
+
+	FShooterAudioVoice()
+		: Component(nullptr)
+		, bPersistent(false)
+	{
+	}
+};
+
+
+/**
+ * Per-world pool of audio components for weapon sounds. Playing a sound reuses a finished component instead of
+ * spawning one, and the number of voices is capped per owner and for the whole world. When a cap is hit the
+ * oldest voice is cut to make room for the new one. Never created on a dedicated server.
+ */
+UCLASS()
+class PROTOTYPE_API UShooterAudioPoolSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+
+	virtual bool ShouldCreateSubsystem(UObject* Outer) const override;
+
+	virtual void Deinitialize() override;
+
+	/**
+	 * Play Sound attached to AttachTo. Persistent voices are for loops the caller stops itself,
+	 * they are never stolen and keep their component until they finish. Returns null if no voice is available.
+	 */
+	UAudioComponent* PlayAttached(USoundBase* Sound, USceneComponent* AttachTo, const AActor* VoiceOwner, bool bPersistent = false);
+
+	int32 GetNumActiveVoices() const;
+
+protected:
+
+	/* Index of the oldest non-persistent voice, of VoiceOwner only when given */
+	int32 FindVoiceToSteal(const AActor* VoiceOwner) const;
+
+	UAudioComponent* CreateComponent();
+
+	void Release(UAudioComponent* Component);
+
+	void OnVoiceFinished(UAudioComponent* Component);
+
+	UPROPERTY(Transient)
+	TArray<UAudioComponent*> FreeComponents;
+
+	/* Oldest first */
+	UPROPERTY(Transient)
+	TArray<FShooterAudioVoice> ActiveVoices;
+};
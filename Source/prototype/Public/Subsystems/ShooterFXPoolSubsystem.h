@@ -0,0 +1,99 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "Tickable.h"
+#include "ShooterFXPoolSubsystem.generated.h"
+
+class UParticleSystem;
+class UParticleSystemComponent;
+class USceneComponent;
+
+
+/* Pooled components of one particle template */
+USTRUCT()
+struct FShooterFXPool
+{
+	GENERATED_BODY()
+
+public:
+
+	/* Inactive, ready to be reused */
+	UPROPERTY(Transient)
+	TArray<UParticleSystemComponent*> Free;
+
+	/* Playing, oldest first */
+	UPROPERTY(Transient)
+	TArray<UParticleSystemComponent*> Active;
+};
+
+
+/**
+ * Per-world pool of particle components for weapon and explosion FX. Components are created once per template
+ * and recycled, the oldest playing one is taken over when a template runs out. Spawns are limited by a per-frame
+ * budget and culled by distance and view direction against the local players' cameras. Never spawns on a dedicated server.
+ */
+UCLASS()
+class PROTOTYPE_API UShooterFXPoolSubsystem : public UWorldSubsystem, public FTickableGameObject
+{
+	GENERATED_BODY()
+
+public:
+
+	UShooterFXPoolSubsystem();
+
+	virtual bool ShouldCreateSubsystem(UObject* Outer) const override;
+
+	virtual void Deinitialize() override;
+
+	/* Create components for Template up front, so the first shots don't pay for them */
+	void Prewarm(UParticleSystem* Template, int32 Count);
+
+	/* Play Template at a location. Returns null when culled or over budget. */
+	UParticleSystemComponent* SpawnAtLocation(UParticleSystem* Template, const FVector& Location, const FRotator& Rotation = FRotator::ZeroRotator);
+
+	/* Play Template attached to a socket. Returns null when culled or over budget. */
+	UParticleSystemComponent* SpawnAttached(UParticleSystem* Template, USceneComponent* AttachTo, FName SocketName);
+
+	/* Play a beam/tracer from Start to End, culled against the whole segment instead of its start */
+	UParticleSystemComponent* SpawnBeam(UParticleSystem* Template, const FVector& Start, const FVector& End, FName TargetParameterName);
+
+	/************************************************************************/
+	/* FTickableGameObject                                                  */
+	/************************************************************************/
+
+	virtual void Tick(float DeltaTime) override;
+
+	virtual ETickableTickType GetTickableTickType() const override;
+
+	virtual bool IsTickable() const override;
+
+	virtual TStatId GetStatId() const override;
+
+	virtual UWorld* GetTickableGameObjectWorld() const override;
+
+protected:
+
+	/* Budget and view check for an effect covering the segment Start-End */
+	bool CanSpawn(const FVector& Start, const FVector& End);
+
+	/* Free component of Template, a new one, or the oldest playing one */
+	UParticleSystemComponent* Acquire(UParticleSystem* Template);
+
+	UParticleSystemComponent* CreateComponent(UParticleSystem* Template);
+
+	UFUNCTION()
+	void OnEffectFinished(UParticleSystemComponent* Component);
+
+	UPROPERTY(Transient)
+	TMap<UParticleSystem*, FShooterFXPool> Pools;
+
+	/* Local player camera locations and directions, refreshed every tick */
+	TArray<FVector> ViewLocations;
+
+	TArray<FVector> ViewDirections;
+
+	int32 SpawnsThisFrame;
+};
@@ -0,0 +1,157 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "Tickable.h"
+#include "WorldCollision.h"
+#include "ShooterHitScanSubsystem.generated.h"
+
+class AShooterWeapon;
+
+
+/* A single hitscan shot waiting for (or waiting on) its trace result */
+struct FShooterHitScanRequest
+{
+	TWeakObjectPtr<AShooterWeapon> Weapon;
+
+	FVector TraceStart;
+
+	FVector TraceEnd;
+
+	FVector ShotDirection;
+
+	/* Server world time the shot was fired at */
+	float Timestamp;
+
+	/* Platform time the shot was queued, used to measure trace latency */
+	double QueuedTime;
+
+	/* Trace group this request belongs to (0 for single shots) and its slot in the group */
+	uint32 GroupId;
+
+	int32 GroupIndex;
+
+	/* Server: also trace the shot with every pawn left out, lag compensation needs the world behind current poses */
+	bool bTraceOcclusion;
+
+	/* Result of that trace, filled in before the request is handed back */
+	FHitResult OcclusionHit;
+
+	FShooterHitScanRequest()
+		: TraceStart(ForceInitToZero)
+		, TraceEnd(ForceInitToZero)
+		, ShotDirection(ForceInitToZero)
+		, Timestamp(0.0f)
+		, QueuedTime(0.0)
+		, GroupId(0)
+		, GroupIndex(INDEX_NONE)
+		, bTraceOcclusion(false)
+	{
+	}
+};
+
+
+/* A submitted shot, complete once its trace and its occlusion trace (if any) came back */
+struct FShooterHitScanInFlight
+{
+	FShooterHitScanRequest Request;
+
+	FHitResult Hit;
+
+	int32 NumPending;
+
+	FShooterHitScanInFlight()
+		: NumPending(0)
+	{
+	}
+};
+
+
+/* Traces of one multi-pellet shot, handed back to the weapon together once all of them completed */
+struct FShooterHitScanGroup
+{
+	TArray<FShooterHitScanRequest, TInlineAllocator<16>> Requests;
+
+	TArray<FHitResult, TInlineAllocator<16>> Hits;
+
+	int32 NumPending;
+};
+
+
+/**
+ * Collects every hitscan shot fired during a frame and sends them to the physics scene as one batch of async traces.
+ * Results come back next frame and are handed to the weapon that fired, which applies damage and replicates the trace.
+ */
+UCLASS()
+class PROTOTYPE_API UShooterHitScanSubsystem : public UWorldSubsystem, public FTickableGameObject
+{
+	GENERATED_BODY()
+
+public:
+
+	UShooterHitScanSubsystem();
+
+	virtual bool ShouldCreateSubsystem(UObject* Outer) const override;
+
+	virtual void Deinitialize() override;
+
+	/* Queue a shot, it will be traced together with all other shots of this frame */
+	void QueueTrace(const FShooterHitScanRequest& Request);
+
+	/* Queue the pellets of one shot. The weapon gets all results in a single OnHitScanGroupCompleted call. */
+	void QueueTraceGroup(TArrayView<const FShooterHitScanRequest> Requests);
+
+	int32 GetNumPendingTraces() const;
+
+	int32 GetNumTracesInFlight() const;
+
+	/************************************************************************/
+	/* FTickableGameObject                                                  */
+	/************************************************************************/
+
+	virtual void Tick(float DeltaTime) override;
+
+	virtual ETickableTickType GetTickableTickType() const override;
+
+	virtual bool IsTickable() const override;
+
+	virtual TStatId GetStatId() const override;
+
+	virtual UWorld* GetTickableGameObjectWorld() const override;
+
+protected:
+
+	/* Send all queued shots to the async trace batch */
+	void FlushPendingTraces();
+
+	void OnTraceCompleted(const FTraceHandle& Handle, FTraceDatum& Data);
+
+	void OnOcclusionTraceCompleted(const FTraceHandle& Handle, FTraceDatum& Data);
+
+	/* Hand a shot whose traces all came back to its weapon (or its group) */
+	void CompleteRequest(uint32 RequestId);
+
+	/* Shots queued this frame, not yet submitted */
+	TArray<FShooterHitScanRequest> PendingRequests;
+
+	/* Submitted shots keyed by the UserData we handed to the async traces */
+	TMap<uint32, FShooterHitScanInFlight> InFlightRequests;
+
+	/* Groups with traces still in flight, keyed by GroupId */
+	TMap<uint32, FShooterHitScanGroup> PendingGroups;
+
+	uint32 NextRequestId;
+
+	uint32 NextGroupId;
+
+	FTraceDelegate TraceDelegate;
+
+	FTraceDelegate OcclusionTraceDelegate;
+
+	/* Latency of all traces resolved since the last tick, in seconds */
+	double ResolvedLatencySum;
+
+	int32 ResolvedCount;
+};
@@ -0,0 +1,39 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "Components/ShooterHitboxHistoryComponent.h"
+#include "ShooterLagCompensationSubsystem.generated.h"
+
+
+/**
+ * Server-side registry of every hitbox history in the world.
+ * Lets the server test a shot against all targets as they were at the time the shot was fired.
+ */
+UCLASS()
+class PROTOTYPE_API UShooterLagCompensationSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+
+	virtual bool ShouldCreateSubsystem(UObject* Outer) const override;
+
+	void RegisterHistory(UShooterHitboxHistoryComponent* History);
+
+	void UnregisterHistory(UShooterHitboxHistoryComponent* History);
+
+	/* Combat between Start and End, wakes the poses of histories within Radius of it for COOP.ServerAnim.AwakeTime */
+	void NotifyCombatActivity(const FVector& Start, const FVector& End, float Radius);
+
+	/* Test a ray against all rewound hitboxes except those of IgnoreActor. Returns the closest hit, if any. */
+	bool RewindRayTest(float Time, const FVector& TraceStart, const FVector& TraceEnd, const AActor* IgnoreActor,
+		FShooterRewindHit& OutHit, UShooterHitboxHistoryComponent*& OutHistory) const;
+
+protected:
+
+	UPROPERTY(Transient)
+	TArray<UShooterHitboxHistoryComponent*> Histories;
+};
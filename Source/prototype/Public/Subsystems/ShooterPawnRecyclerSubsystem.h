@@ -0,0 +1,91 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "Tickable.h"
+#include "UObject/Interface.h"
+#include "ShooterPawnRecyclerSubsystem.generated.h"
+
+class APawn;
+
+
+UINTERFACE(MinimalAPI)
+class UShooterRecyclable : public UInterface
+{
+	GENERATED_BODY()
+};
+
+/* Pawns that can be handed back to the recycler when they die instead of being destroyed */
+class PROTOTYPE_API IShooterRecyclable
+{
+	GENERATED_BODY()
+
+public:
+
+	/* Corpse time is up: hide, stop ticking and drop anything that shouldn't survive into the next life */
+	virtual void StoreCorpse() = 0;
+
+	/* Server, bring the pawn back to its spawned state at SpawnTransform */
+	virtual void ResetForReuse(const FTransform& SpawnTransform) = 0;
+};
+
+
+/**
+ * Server-side pool of dead pawns. Dead pawns stay in the world as corpses for their corpse time,
+ * are then hidden and wait to be reset and reused by the next player respawn or bot spawn.
+ * Only classes something has acquired are pooled, the rest are destroyed as before. Each class is
+ * capped by COOP.Recycler.MaxCorpses, the least recently retired corpse of it is destroyed first.
+ */
+UCLASS()
+class PROTOTYPE_API UShooterPawnRecyclerSubsystem : public UWorldSubsystem, public FTickableGameObject
+{
+	GENERATED_BODY()
+
+public:
+
+	virtual bool ShouldCreateSubsystem(UObject* Outer) const override;
+
+	virtual void Deinitialize() override;
+
+	/* Server, take over a dead pawn. Returns false if recycling is off or the pawn's class isn't pooled, the caller destroys it then. */
+	bool RetirePawn(APawn* Pawn, float CorpseTime);
+
+	/* Server, a stored pawn of exactly PawnClass reset at SpawnTransform, or null if there is none */
+	APawn* AcquirePawn(TSubclassOf<APawn> PawnClass, const FTransform& SpawnTransform);
+
+	/************************************************************************/
+	/* FTickableGameObject                                                  */
+	/************************************************************************/
+
+	virtual void Tick(float DeltaTime) override;
+
+	virtual ETickableTickType GetTickableTickType() const override;
+
+	virtual bool IsTickable() const override;
+
+	virtual TStatId GetStatId() const override;
+
+	virtual UWorld* GetTickableGameObjectWorld() const override;
+
+protected:
+
+	struct FCorpse
+	{
+		TWeakObjectPtr<APawn> Pawn;
+
+		/* World time the corpse gets stored */
+		float StoreTime;
+
+		bool bStored;
+	};
+
+	/* Oldest first */
+	TArray<FCorpse> Corpses;
+
+	/* Classes AcquirePawn was asked for. A class nobody spawns through us, e.g. bots while the spawn
+	   Blueprint still uses SpawnActor, would only fill the pool with corpses that are never reused. */
+	UPROPERTY(Transient)
+	TSet<UClass*> RequestedClasses;
+};
@@ -0,0 +1,238 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "Tickable.h"
+#include "WorldCollision.h"
+#include "Engine/NetSerialization.h"
+#include "ShooterProjectileSubsystem.generated.h"
+
+class UDamageType;
+class UParticleSystem;
+class USoundCue;
+class UStaticMesh;
+class UInstancedStaticMeshComponent;
+class AShooterProjectileWeapon;
+
+
+/* How a kind of projectile flies and explodes, set up on the weapon that fires it */
+USTRUCT(BlueprintType)
+struct FShooterProjectileParams
+{
+	GENERATED_BODY()
+
+public:
+
+	UPROPERTY(EditDefaultsOnly, Category = "Projectile")
+	float Speed;
+
+	UPROPERTY(EditDefaultsOnly, Category = "Projectile")
+	float GravityScale;
+
+	/* Radius of the collision sphere */
+	UPROPERTY(EditDefaultsOnly, Category = "Projectile", meta = (ClampMin = 0.0f))
+	float CollisionRadius;
+
+	/* Explode on the first blocking hit, otherwise bounce until the fuse runs out */
+	UPROPERTY(EditDefaultsOnly, Category = "Projectile")
+	bool bExplodeOnImpact;
+
+	/* Velocity kept on a bounce */
+	UPROPERTY(EditDefaultsOnly, Category = "Projectile", meta = (ClampMin = 0.0f, ClampMax = 1.0f))
+	float Restitution;
+
+	/* Seconds until the projectile explodes on its own, 0 for none */
+	UPROPERTY(EditDefaultsOnly, Category = "Projectile", meta = (ClampMin = 0.0f))
+	float FuseTime;
+
+	/* Seconds until the projectile is removed without exploding */
+	UPROPERTY(EditDefaultsOnly, Category = "Projectile", meta = (ClampMin = 0.0f))
+	float Lifetime;
+
+	UPROPERTY(EditDefaultsOnly, Category = "Damage")
+	float ExplosionDamage;
+
+	UPROPERTY(EditDefaultsOnly, Category = "Damage")
+	float ExplosionRadius;
+
+	UPROPERTY(EditDefaultsOnly, Category = "Damage")
+	TSubclassOf<UDamageType> DamageType;
+
+	UPROPERTY(EditDefaultsOnly, Category = "Effects")
+	UParticleSystem* ExplosionEffect;
+
+	UPROPERTY(EditDefaultsOnly, Category = "Effects")
+	USoundCue* ExplosionSound;
+
+	/* Drawn as an instance on clients, never spawned on a dedicated server */
+	UPROPERTY(EditDefaultsOnly, Category = "Effects")
+	UStaticMesh* ProxyMesh;
+
+	FShooterProjectileParams()
+		: Speed(2000.0f)
+		, GravityScale(1.0f)
+		, CollisionRadius(5.0f)
+		, bExplodeOnImpact(false)
+		, Restitution(0.4f)
+		, FuseTime(1.0f)
+		, Lifetime(10.0f)
+		, ExplosionDamage(100.0f)
+		, ExplosionRadius(300.0f)
+		, ExplosionEffect(nullptr)
+		, ExplosionSound(nullptr)
+		, ProxyMesh(nullptr)
+	{
+	}
+};
+
+
+/* Everything a client needs to simulate a projectile the server fired */
+USTRUCT()
+struct FShooterProjectileSpawn
+{
+	GENERATED_BODY()
+
+public:
+
+	UPROPERTY()
+	FVector_NetQuantize Origin;
+
+	UPROPERTY()
+	FVector_NetQuantize10 Velocity;
+
+	/* Server world time the projectile was fired at */
+	UPROPERTY()
+	float Timestamp;
+
+	/* Per-weapon projectile number, identifies the projectile on its weapon on every machine */
+	UPROPERTY()
+	int32 ShotId;
+};
+
+
+/**
+ * Simulates projectiles as plain data instead of actors. Live projectiles are kept in parallel arrays,
+ * integrated in one pass per tick, and their movement is swept as one batch of async sweeps whose
+ * results are resolved the next tick. Clients draw them through one instanced mesh per projectile mesh.
+ *
+ * Only the server's projectiles are authoritative. Client copies simulate the same trajectory from the
+ * replicated spawn, and when they would explode they wait for the server's detonation instead.
+ */
+UCLASS()
+class PROTOTYPE_API UShooterProjectileSubsystem : public UWorldSubsystem, public FTickableGameObject
+{
+	GENERATED_BODY()
+
+public:
+
+	UShooterProjectileSubsystem();
+
+	virtual bool ShouldCreateSubsystem(UObject* Outer) const override;
+
+	virtual void Deinitialize() override;
+
+	/* Type index for Params, registered once per Key (the firing weapon's class) */
+	int32 RegisterProjectileType(const UClass* Key, const FShooterProjectileParams& Params);
+
+	/**
+	 * Launch a projectile, ElapsedTime seconds after it was fired. Only authoritative projectiles deal damage
+	 * and replicate their detonation, the others are cosmetic copies on clients.
+	 */
+	void SpawnProjectile(int32 Type, const FVector& Location, const FVector& Velocity, float ElapsedTime, AShooterProjectileWeapon* Weapon,
+		int32 ShotId, AController* InstigatorController, bool bAuthoritative);
+
+	/* Server detonated the projectile Weapon fired as ShotId, explode the local copy there (or just play the effects) */
+	void DetonateProjectile(int32 Type, const AShooterProjectileWeapon* Weapon, int32 ShotId, const FVector& Location);
+
+	int32 GetNumProjectiles() const;
+
+	/************************************************************************/
+	/* FTickableGameObject                                                  */
+	/************************************************************************/
+
+	virtual void Tick(float DeltaTime) override;
+
+	virtual ETickableTickType GetTickableTickType() const override;
+
+	virtual bool IsTickable() const override;
+
+	virtual TStatId GetStatId() const override;
+
+	virtual UWorld* GetTickableGameObjectWorld() const override;
+
+protected:
+
+	/* Apply the sweep results that came back since the last tick */
+	void ResolvePendingHits();
+
+	/* Move every projectile and count down its fuse and lifetime */
+	void Integrate(float DeltaTime);
+
+	/* Sweep every projectile's movement of this tick as one batch */
+	void SubmitSweeps();
+
+	/* Bring the instanced proxies in line with the live projectiles */
+	void UpdateProxies();
+
+	/* Authoritative projectiles explode, client copies start waiting for the server's detonation */
+	void Explode(int32 Index);
+
+	void PlayExplosionEffects(const FShooterProjectileParams& Params, const FVector& Location) const;
+
+	/* Swap-remove a projectile from every array */
+	void RemoveProjectile(int32 Index);
+
+	void OnSweepCompleted(const FTraceHandle& Handle, FTraceDatum& Data);
+
+	TArray<FShooterProjectileParams> Types;
+
+	TMap<const UClass*, int32> TypesByKey;
+
+	/* Live projectiles, one entry per projectile in each array */
+	TArray<FVector> Positions;
+
+	/* Start of the path not swept yet. A new copy starts at its muzzle, so the first sweep covers its catch-up too. */
+	TArray<FVector> PreviousPositions;
+
+	TArray<FVector> Velocities;
+
+	TArray<float> GravityScales;
+
+	TArray<float> Lifetimes;
+
+	TArray<float> Fuses;
+
+	TArray<uint16> TypeIndices;
+
+	TArray<uint32> Ids;
+
+	TArray<int32> ShotIds;
+
+	TArray<bool> Authoritative;
+
+	/* Client copy that reached its detonation and is held in place until the server's arrives */
+	TArray<bool> AwaitingDetonation;
+
+	TArray<TWeakObjectPtr<AShooterProjectileWeapon>> Weapons;
+
+	TArray<TWeakObjectPtr<AController>> InstigatorControllers;
+
+	/* Index of each live projectile by Id, kept up to date on swap-removal */
+	TMap<uint32, int32> IndexById;
+
+	/* Sweep hits delivered by the physics thread, applied next tick */
+	TArray<TPair<uint32, FHitResult>> PendingHits;
+
+	uint32 NextId;
+
+	FTraceDelegate SweepDelegate;
+
+	/* Holds the instanced mesh components for proxies, not spawned on dedicated servers */
+	UPROPERTY(Transient)
+	AActor* ProxyActor;
+
+	UPROPERTY(Transient)
+	TMap<UStaticMesh*, UInstancedStaticMeshComponent*> ProxyComponents;
+};
@@ -0,0 +1,94 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "Tickable.h"
+#include "ShooterSignificanceSubsystem.generated.h"
+
+
+/* How much an actor matters to the players that can see it, from most to least */
+UENUM(BlueprintType)
+enum class EShooterSignificance : uint8
+{
+	High,
+	Medium,
+	Low,
+	Dormant,
+	MAX UMETA(Hidden)
+};
+
+
+DECLARE_DELEGATE_OneParam(FShooterSignificanceChanged, EShooterSignificance);
+
+
+/**
+ * Scores registered actors by distance to the players' views (local ones on clients, every player on the server),
+ * with actors behind a view counting as further away. The score picks a tier, actors scale their tick interval,
+ * animation, effects and AI think rate from it. Tiers are tuned through the COOP.Significance.* console variables.
+ */
+UCLASS()
+class PROTOTYPE_API UShooterSignificanceSubsystem : public UWorldSubsystem, public FTickableGameObject
+{
+	GENERATED_BODY()
+
+public:
+
+	UShooterSignificanceSubsystem();
+
+	virtual bool ShouldCreateSubsystem(UObject* Outer) const override;
+
+	virtual void Deinitialize() override;
+
+	/* OnChanged runs right away with the actor's first tier and again whenever it changes */
+	void RegisterActor(AActor* Actor, const FShooterSignificanceChanged& OnChanged);
+
+	void UnregisterActor(AActor* Actor);
+
+	/* Actor tick interval for a tier */
+	static float GetTickInterval(EShooterSignificance Significance);
+
+	/* Multiplier for AI timers (path refresh, target checks) for a tier */
+	static float GetThinkIntervalScale(EShooterSignificance Significance);
+
+	/************************************************************************/
+	/* FTickableGameObject                                                  */
+	/************************************************************************/
+
+	virtual void Tick(float DeltaTime) override;
+
+	virtual ETickableTickType GetTickableTickType() const override;
+
+	virtual bool IsTickable() const override;
+
+	virtual TStatId GetStatId() const override;
+
+	virtual UWorld* GetTickableGameObjectWorld() const override;
+
+protected:
+
+	struct FEntry
+	{
+		TWeakObjectPtr<AActor> Actor;
+
+		FShooterSignificanceChanged OnChanged;
+
+		EShooterSignificance Significance;
+	};
+
+	/* Re-score every registered actor against the current player views */
+	void UpdateSignificance();
+
+	void GatherViews();
+
+	EShooterSignificance ScoreActor(const AActor* Actor) const;
+
+	TArray<FEntry> Entries;
+
+	TArray<FVector> ViewLocations;
+
+	TArray<FVector> ViewDirections;
+
+	float TimeSinceUpdate;
+};
@@ -0,0 +1,58 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "ShooterUsableSubsystem.generated.h"
+
+class AShooterUsableActor;
+class USceneComponent;
+
+
+/**
+ * Registry of every usable actor in the world, bucketed in a uniform 2D grid.
+ * Lets players skip focus traces entirely when nothing usable is within reach,
+ * and lets the server check a use request against the same candidates.
+ */
+UCLASS()
+class PROTOTYPE_API UShooterUsableSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+
+	UShooterUsableSubsystem();
+
+	virtual bool ShouldCreateSubsystem(UObject* Outer) const override;
+
+	virtual void Deinitialize() override;
+
+	void RegisterUsable(AShooterUsableActor* Usable);
+
+	void UnregisterUsable(AShooterUsableActor* Usable);
+
+	/* Usables whose bounds come within Radius of Location */
+	void GatherUsablesInRange(const FVector& Location, float Radius, TArray<AShooterUsableActor*>& OutUsables) const;
+
+	bool HasUsableInRange(const FVector& Location, float Radius) const;
+
+	bool IsUsableInRange(const AShooterUsableActor* Usable, const FVector& Location, float Radius) const;
+
+protected:
+
+	FIntPoint GetCell(const FVector& Location) const;
+
+	/* Move a usable to its new cell when it moves, e.g. a dropped weapon settling */
+	void OnUsableMoved(USceneComponent* UpdatedComponent, EUpdateTransformFlags UpdateTransformFlags, ETeleportType Teleport);
+
+	/* Largest usable bounds radius seen, widens the cell search so big usables aren't missed */
+	float MaxUsableRadius;
+
+	/* Edge length of a grid cell, in the order of MaxUseDistance */
+	float CellSize;
+
+	TMap<FIntPoint, TArray<TWeakObjectPtr<AShooterUsableActor>>> Cells;
+
+	TMap<TWeakObjectPtr<AShooterUsableActor>, FIntPoint> UsableCells;
+};
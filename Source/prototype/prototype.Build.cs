@@ -17,6 +17,7 @@ public class prototype : ModuleRules
 			"GameplayTasks",
 			"OnlineSubsystem",
 			"PhysicsCore", 
+			"NetCore",
 			"NavigationSystem" 
 		});
 
@@ -3,8 +3,12 @@
 #pragma once
 
 #include "CoreMinimal.h"
+#include "Stats/Stats.h"
 
 #define SURFACE_FLESHDEFAULT		SurfaceType1
 #define SURFACE_FLESHVULNERABLE		SurfaceType2
 
-#define COLLISION_WEAPON			ECC_GameTraceChannel1
\ No newline at end of file
+#define COLLISION_WEAPON			ECC_GameTraceChannel1
+#define COLLISION_HITBOX			ECC_GameTraceChannel2
+
+DECLARE_STATS_GROUP(TEXT("Prototype"), STATGROUP_Prototype, STATCAT_Advanced);